@@ -0,0 +1,8 @@
+rem Optional: regenerates the hex array headers the Arduino IDE sketch in the
+rem repository root includes. The PlatformIO build uses ConvertTextures.bat.
+python pic2array.py assets/SpiralFaceShadow.png include
+python pic2array.py assets/SpiralFaceShadowCenter.png include
+python pic2array.py assets/SpiralFaceWithShadow.png include
+python pic2array.py assets/MatCapSource.png include
+python pic2array.py assets/BlueNoise200.png include
+pause
@@ -1,4 +1,3 @@
-python pic2array.py assets/SpiralFaceShadow.png include
-python pic2array.py assets/SpiralFaceShadowCenter.png include
-python pic2array.py assets/SpiralFaceWithShadow.png include
-pause
\ No newline at end of file
+cmake -S . -B build
+cmake --build build --target textures
+pause
@@ -0,0 +1,89 @@
+// Generated by tools/AssetCompiler.cpp from assets/Textures.txt, do not edit.
+// The blobs are in include/textures/, linked once by src/Textures.S, and the
+// ones on the pack line packed into include/textures/Textures.pack for the
+// textures partition.
+//
+// asset SpiralFaceShadow.png : 57609229c38d9337
+// asset SpiralFaceShadowCenter.png --minmax --palette4 : d71923085ebfcb62
+// asset SpiralFaceWithShadow.png --minmax --mips --palette4 --padded --tiled4 --tiled8 --morton : 91cc2cc0b8d3a13e
+// asset MatCapSource.png --minmax --mips --palette4 : 0953cc183cfd2844
+// asset BlueNoise200.png --minmax-rows : cfe1eb2d1dee8a04
+
+#pragma once
+
+#if SPIRAL_TEXTURE_PARTITION
+// The packed blobs and their offsets in include/textures/Textures.pack. Their
+// pointers are null until mapTextures() (src/TexturePartition.cpp) points them
+// into the textures partition; it returns an error message, or nullptr.
+#define TEXTURE_PACK_LAYOUT 0x8c0ddef4u
+#define TEXTURE_PACK_SIZE 120016
+#define TEXTURE_PACK_BLOBS(X) \
+    X(SpiralFaceShadowCenter, 16) \
+    X(SpiralFaceWithShadow, 40016) \
+    X(MatCapSource, 80016)
+
+const char *mapTextures();
+
+extern "C" {
+extern const unsigned char SpiralFaceShadowLinked[40000];
+static const unsigned char *const SpiralFaceShadow = SpiralFaceShadowLinked;
+extern const unsigned char *SpiralFaceShadowCenter;
+extern const unsigned char SpiralFaceShadowCenterMinMaxLinked[26728];
+static const unsigned char *const SpiralFaceShadowCenterMinMax = SpiralFaceShadowCenterMinMaxLinked;
+extern const unsigned char SpiralFaceShadowCenterPalette4Linked[20016];
+static const unsigned char *const SpiralFaceShadowCenterPalette4 = SpiralFaceShadowCenterPalette4Linked;
+extern const unsigned char *SpiralFaceWithShadow;
+extern const unsigned char SpiralFaceWithShadowMinMaxLinked[26728];
+static const unsigned char *const SpiralFaceWithShadowMinMax = SpiralFaceWithShadowMinMaxLinked;
+extern const unsigned char SpiralFaceWithShadowMipsLinked[60000];
+static const unsigned char *const SpiralFaceWithShadowMips = SpiralFaceWithShadowMipsLinked;
+extern const unsigned char SpiralFaceWithShadowMipsMinMaxLinked[40092];
+static const unsigned char *const SpiralFaceWithShadowMipsMinMax = SpiralFaceWithShadowMipsMinMaxLinked;
+extern const unsigned char SpiralFaceWithShadowPalette4Linked[20016];
+static const unsigned char *const SpiralFaceWithShadowPalette4 = SpiralFaceWithShadowPalette4Linked;
+extern const unsigned char SpiralFaceWithShadowPaddedLinked[51144];
+static const unsigned char *const SpiralFaceWithShadowPadded = SpiralFaceWithShadowPaddedLinked;
+extern const unsigned char SpiralFaceWithShadowTiled4Linked[40000];
+static const unsigned char *const SpiralFaceWithShadowTiled4 = SpiralFaceWithShadowTiled4Linked;
+extern const unsigned char SpiralFaceWithShadowTiled8Linked[40000];
+static const unsigned char *const SpiralFaceWithShadowTiled8 = SpiralFaceWithShadowTiled8Linked;
+extern const unsigned char SpiralFaceWithShadowMortonLinked[61504];
+static const unsigned char *const SpiralFaceWithShadowMorton = SpiralFaceWithShadowMortonLinked;
+extern const unsigned char *MatCapSource;
+extern const unsigned char MatCapSourceMinMaxLinked[26728];
+static const unsigned char *const MatCapSourceMinMax = MatCapSourceMinMaxLinked;
+extern const unsigned char MatCapSourceMipsLinked[60000];
+static const unsigned char *const MatCapSourceMips = MatCapSourceMipsLinked;
+extern const unsigned char MatCapSourceMipsMinMaxLinked[40092];
+static const unsigned char *const MatCapSourceMipsMinMax = MatCapSourceMipsMinMaxLinked;
+extern const unsigned char MatCapSourcePalette4Linked[20016];
+static const unsigned char *const MatCapSourcePalette4 = MatCapSourcePalette4Linked;
+extern const unsigned char BlueNoise200Linked[40000];
+static const unsigned char *const BlueNoise200 = BlueNoise200Linked;
+extern const unsigned char BlueNoise200MinMaxLinked[10000];
+static const unsigned char *const BlueNoise200MinMax = BlueNoise200MinMaxLinked;
+}
+#else
+extern "C" {
+extern const unsigned char SpiralFaceShadow[40000];
+extern const unsigned char SpiralFaceShadowCenter[40000];
+extern const unsigned char SpiralFaceShadowCenterMinMax[26728];
+extern const unsigned char SpiralFaceShadowCenterPalette4[20016];
+extern const unsigned char SpiralFaceWithShadow[40000];
+extern const unsigned char SpiralFaceWithShadowMinMax[26728];
+extern const unsigned char SpiralFaceWithShadowMips[60000];
+extern const unsigned char SpiralFaceWithShadowMipsMinMax[40092];
+extern const unsigned char SpiralFaceWithShadowPalette4[20016];
+extern const unsigned char SpiralFaceWithShadowPadded[51144];
+extern const unsigned char SpiralFaceWithShadowTiled4[40000];
+extern const unsigned char SpiralFaceWithShadowTiled8[40000];
+extern const unsigned char SpiralFaceWithShadowMorton[61504];
+extern const unsigned char MatCapSource[40000];
+extern const unsigned char MatCapSourceMinMax[26728];
+extern const unsigned char MatCapSourceMips[60000];
+extern const unsigned char MatCapSourceMipsMinMax[40092];
+extern const unsigned char MatCapSourcePalette4[20016];
+extern const unsigned char BlueNoise200[40000];
+extern const unsigned char BlueNoise200MinMax[10000];
+}
+#endif
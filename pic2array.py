@@ -11,6 +11,9 @@ Usage:
 The script outputs a C declaration of a static array. Code output may be easily
 included in source code managed by the Arduino IDE.
 
+The PlatformIO build in src/ does not use these headers: tools/AssetCompiler.cpp
+builds its textures, and everything derived from them, as binary blobs.
+
 See full documentation in README.md
 :copyright: (c) 2015 by Jean-Yves VET.
 :license: MIT, see LICENSE for more details.
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Signed Q16.16 fixed point number. Products and quotients go through a 64 bit
+// intermediate, which the ESP32 handles with plain integer instructions instead
+// of the soft-float routines double arithmetic ends up in.
+struct Fixed
+{
+    static const int FRACTION_BITS = 16;
+    static const int32_t ONE = 1 << FRACTION_BITS;
+
+    int32_t raw;
+
+public:
+    Fixed() : raw(0) {}
+    constexpr Fixed(int value) : raw(value * ONE) {}
+    constexpr Fixed(float value) : raw((int32_t)(value * ONE + (value >= 0 ? 0.5f : -0.5f))) {}
+    constexpr Fixed(double value) : raw((int32_t)(value * ONE + (value >= 0 ? 0.5 : -0.5))) {}
+
+    static Fixed fromRaw(int32_t raw)
+    {
+        Fixed f;
+        f.raw = raw;
+        return f;
+    }
+
+    // Truncates towards zero, like a double to int conversion would.
+    explicit operator int() const { return raw >= 0 ? raw >> FRACTION_BITS : -(-raw >> FRACTION_BITS); }
+    explicit operator int16_t() const { return (int16_t)(int)*this; }
+    explicit operator float() const { return raw * (1.0f / ONE); }
+    explicit operator double() const { return raw * (1.0 / ONE); }
+
+    friend Fixed operator+(Fixed a, Fixed b) { return fromRaw(a.raw + b.raw); }
+    friend Fixed operator-(Fixed a, Fixed b) { return fromRaw(a.raw - b.raw); }
+    friend Fixed operator*(Fixed a, Fixed b) { return fromRaw((int32_t)(((int64_t)a.raw * b.raw) >> FRACTION_BITS)); }
+    friend Fixed operator/(Fixed a, Fixed b) { return fromRaw((int32_t)(((int64_t)a.raw << FRACTION_BITS) / b.raw)); }
+    Fixed operator-() const { return fromRaw(-raw); }
+
+    Fixed& operator+=(Fixed a) { raw += a.raw; return *this; }
+    Fixed& operator-=(Fixed a) { raw -= a.raw; return *this; }
+    Fixed& operator*=(Fixed a) { return *this = *this * a; }
+    Fixed& operator/=(Fixed a) { return *this = *this / a; }
+
+    friend bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+    friend bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+    friend bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+    friend bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+    friend bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+    friend bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+};
+
+// Transcendentals are only needed during geometry setup, so they go through
+// single precision float rather than fixed point approximations.
+inline double scalarSqrt(double v) { return sqrt(v); }
+inline float scalarSqrt(float v) { return sqrtf(v); }
+inline Fixed scalarSqrt(Fixed v) { return Fixed(sqrtf((float)v)); }
+
+inline double scalarSin(double v) { return sin(v); }
+inline float scalarSin(float v) { return sinf(v); }
+inline Fixed scalarSin(Fixed v) { return Fixed(sinf((float)v)); }
+
+inline double scalarCos(double v) { return cos(v); }
+inline float scalarCos(float v) { return cosf(v); }
+inline Fixed scalarCos(Fixed v) { return Fixed(cosf((float)v)); }
+
+inline double scalarPow(double b, double e) { return pow(b, e); }
+inline float scalarPow(float b, float e) { return powf(b, e); }
+inline Fixed scalarPow(Fixed b, Fixed e) { return Fixed(powf((float)b, (float)e)); }
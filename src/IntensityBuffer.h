@@ -0,0 +1,106 @@
+#pragma once
+
+#include <Watchy.h>
+#include "RenderConfig.h"
+#include "RenderStats.h"
+#include "Rasterizer.h"
+#include "RenderTarget.h"
+#include "PrimitiveList.h"
+#include "Shaders.h"
+#include "Threshold.h"
+
+// Two pass renderer that takes dithering out of the rasterizer. Dithered
+// texture spans store their plain 8 bit texels in a grayscale buffer, and
+// present() thresholds the whole buffer against the blue noise mask in one
+// linear pass (Threshold.h). The texture fetches stay in the span loops, but
+// the noise is read once per frame, in order, instead of at every covered
+// pixel. The grayscale frame stays around until the next fill(), for
+// anything that wants to compare or keep it.
+//
+// No intensity stays white against every noise value, so pixels other
+// shaders, the outlines and fill() write are solid instead: they go straight
+// into the frame buffer and are marked to be left alone by the threshold.
+struct IntensityBuffer
+{
+    FrameBuffer frame;
+    uint8_t solid[FrameBuffer::STRIDE * SCREEN_HEIGHT];   // packed like the frame buffer
+    uint8_t intensity[SCREEN_WIDTH * SCREEN_HEIGHT];
+
+    void startWrite() {}
+    void endWrite() {}
+
+    void fill(uint16_t color)
+    {
+        frame.fill(color);
+        memset(solid, 0xFF, sizeof(solid));
+    }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color)
+    {
+        if (x < 0 || x >= SCREEN_WIDTH || y < 0 || y >= SCREEN_HEIGHT)
+            return;
+
+        frame.drawPixel(x, y, color);
+        solid[y * FrameBuffer::STRIDE + (x >> 3)] |= 0x80 >> (x & 7);
+    }
+
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+        RasterLine line;
+        line.init(x0, y0, x1, y1, color);
+        line.draw(*this, 0, 0, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1);
+    }
+
+    // Any other shader runs now, as the frame buffer would run it.
+    template <typename Shader>
+    void shadeSpan(int x, int y, int w, int32_t u, int32_t v, int32_t dudx, int32_t dvdx, const Shader& shader)
+    {
+        for (int end = x + w; x < end; x++)
+        {
+            uint16_t color;
+
+            RENDER_SHADED(x, y);
+
+            if (shader(x, y, u >> Fixed::FRACTION_BITS, v >> Fixed::FRACTION_BITS, color))
+                drawPixel(x, y, color);
+
+            u += dudx;
+            v += dvdx;
+        }
+    }
+
+    // Dithered textures only store their texels.
+    template <typename Texture>
+    void shadeSpan(int x, int y, int w, int32_t u, int32_t v, int32_t dudx, int32_t dvdx,
+                   const DitherShader<Texture>& shader)
+    {
+        uint8_t *out = intensity + y * SCREEN_WIDTH + x;
+
+        for (int i = 0; i < w; i++)
+        {
+            RENDER_SHADED(x + i, y);
+
+            out[i] = shader.texture.texel(u >> Fixed::FRACTION_BITS, v >> Fixed::FRACTION_BITS);
+            u += dudx;
+            v += dvdx;
+        }
+
+        uint8_t *row = solid + y * FrameBuffer::STRIDE;
+
+        for (int end = x + w; x < end;)
+        {
+            int byteEnd = (x | 7) + 1;
+            if (byteEnd > end)
+                byteEnd = end;
+
+            row[x >> 3] &= ~FrameBuffer::runMask(x, byteEnd);
+            x = byteEnd;
+        }
+    }
+
+    void present()
+    {
+        thresholdBytes(intensity, BlueNoise200, solid, frame.bytes, FrameBuffer::STRIDE * SCREEN_HEIGHT);
+        frame.present();
+    }
+};
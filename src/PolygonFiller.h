@@ -0,0 +1,211 @@
+#pragma once
+
+#include <Arduino.h>
+#include "RenderConfig.h"
+#include "RenderStats.h"
+#include "Rasterizer.h"
+
+// Scanline filler for polygons made of any number of closed contours, under
+// the non-zero winding rule: a pixel is filled when the contours wind around
+// its center a non-zero number of times. Where a contour runs along the same
+// edge twice in opposite directions the two cancel, so a band that touches
+// itself can still be outlined as one shape. Edges are walked with the same
+// edge walkers as triangles, under the same top-left rule, so a polygon
+// covers exactly the pixels a triangulation of it would.
+//
+// Polygons have no vertex attributes. Spans are cut at every edge they meet,
+// even where the winding stays non-zero, and a Mapping functor gives the
+// Q16.16 texture coordinates and their step along each of them. A mapping
+// only has to be continuous between edges, so edges that cancel can still
+// separate differently textured parts. Vertices must lie inside the guard
+// band.
+template <int MaxEdges>
+struct PolygonFiller
+{
+    struct Edge
+    {
+        int16_t x0, y0, x1, y1;   // subpixels, top to bottom
+        int8_t winding;           // +1 when the contour runs down, -1 up
+    };
+
+    struct ActiveEdge
+    {
+        EdgeWalker walker;
+        int8_t winding;
+    };
+
+    Edge edges[MaxEdges];
+    int edgeCount = 0;
+
+    // Edge indices sorted by first row, and the edges crossing the current row.
+    uint16_t rowStart[SCREEN_HEIGHT + 1];
+    uint16_t edgeTable[MaxEdges];
+    ActiveEdge active[MaxEdges];
+
+    void clear()
+    {
+        edgeCount = 0;
+        contourPoints = 0;
+    }
+
+    // Appends a point to the current contour.
+    void addPoint(const Vector& position)
+    {
+        int16_t x = toSubpixel(position.x), y = toSubpixel(position.y);
+
+        if (contourPoints++ == 0)
+        {
+            firstX = x;
+            firstY = y;
+        }
+        else
+        {
+            addEdge(lastX, lastY, x, y);
+        }
+
+        lastX = x;
+        lastY = y;
+    }
+
+    // Closes the current contour back to its first point.
+    void closeContour()
+    {
+        if (contourPoints > 1)
+            addEdge(lastX, lastY, firstX, firstY);
+
+        contourPoints = 0;
+    }
+
+    // Fills the polygon row by row and clears it.
+    template <typename Target, typename Mapping, typename Shader>
+    void fill(Target& target, const Mapping& mapping, const Shader& shader)
+    {
+        RENDER_STAT(polygonEdges, edgeCount);
+
+        // Counting sort by first row. Edges starting below the screen go to
+        // the last bucket, which is never read.
+        memset(rowStart, 0, sizeof(rowStart));
+
+        for (int i = 0; i < edgeCount; i++)
+            rowStart[firstRow(edges[i])]++;
+
+        for (int y = 1; y <= SCREEN_HEIGHT; y++)
+            rowStart[y] += rowStart[y - 1];
+
+        for (int i = edgeCount - 1; i >= 0; i--)
+            edgeTable[--rowStart[firstRow(edges[i])]] = i;
+
+        int activeCount = 0;
+
+        target.startWrite();
+
+        for (int y = 0; y < SCREEN_HEIGHT; y++)
+        {
+            for (int e = rowStart[y]; e < rowStart[y + 1]; e++)
+            {
+                const Edge &edge = edges[edgeTable[e]];
+                RasterVertex top = {edge.x0, edge.y0, 0, 0}, bottom = {edge.x1, edge.y1, 0, 0};
+                ActiveEdge &a = active[activeCount];
+
+                a.walker.init(top, bottom, 0, SCREEN_HEIGHT);
+                a.winding = edge.winding;
+
+                // Edges ending above the screen start and end on row 0.
+                if (a.walker.y < a.walker.yEnd)
+                    activeCount++;
+            }
+
+            // Insertion sort by x. The order rarely changes between rows.
+            for (int i = 1; i < activeCount; i++)
+            {
+                ActiveEdge a = active[i];
+                int j = i;
+
+                for (; j > 0 && active[j - 1].walker.x > a.walker.x; j--)
+                    active[j] = active[j - 1];
+
+                active[j] = a;
+            }
+
+            int winding = 0;
+
+            for (int i = 0; i + 1 < activeCount; i++)
+            {
+                winding += active[i].winding;
+
+                if (winding != 0)
+                    shadeSpan(target, active[i].walker.x, active[i + 1].walker.x, y, mapping, shader);
+            }
+
+            // Step down a row, dropping the edges that end here.
+            int kept = 0;
+
+            for (int i = 0; i < activeCount; i++)
+            {
+                active[i].walker.advance();
+
+                if (active[i].walker.y < active[i].walker.yEnd)
+                    active[kept++] = active[i];
+            }
+
+            activeCount = kept;
+        }
+
+        target.endWrite();
+
+        clear();
+    }
+
+private:
+    int contourPoints = 0;
+    int16_t firstX, firstY, lastX, lastY;
+
+    // Horizontal edges cross no rows and are left out. MaxEdges has to cover
+    // the largest polygon drawn, anything beyond it is dropped.
+    void addEdge(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+    {
+        if (y0 == y1 || edgeCount == MaxEdges)
+            return;
+
+        Edge &edge = edges[edgeCount++];
+
+        if (y0 < y1)
+        {
+            edge.x0 = x0; edge.y0 = y0;
+            edge.x1 = x1; edge.y1 = y1;
+            edge.winding = 1;
+        }
+        else
+        {
+            edge.x0 = x1; edge.y0 = y1;
+            edge.x1 = x0; edge.y1 = y0;
+            edge.winding = -1;
+        }
+    }
+
+    static int firstRow(const Edge& edge)
+    {
+        return constrain(ceilDiv(edge.y0, SUBPIXEL_ONE), 0, SCREEN_HEIGHT);
+    }
+
+    template <typename Target, typename Mapping, typename Shader>
+    void shadeSpan(Target& target, int x, int end, int y, const Mapping& mapping, const Shader& shader)
+    {
+        if (x < 0)
+            x = 0;
+        if (end > SCREEN_WIDTH)
+            end = SCREEN_WIDTH;
+
+        if (end <= x)
+            return;
+
+        int w = end - x;
+        int32_t u, v, dudx, dvdx;
+        mapping(x, y, w, u, v, dudx, dvdx);
+
+        RENDER_STAT(polygonSpans, 1);
+        RENDER_STAT(shadedPixels, w);
+        RENDER_OVERDRAW(x, y, w);
+        sampleSpan(target, x, y, w, u, v, dudx, dvdx, shader);
+    }
+};
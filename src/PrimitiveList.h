@@ -0,0 +1,221 @@
+#pragma once
+
+#include <Watchy.h>
+#include "RenderConfig.h"
+#include "RenderStats.h"
+#include "Rasterizer.h"
+#include "RenderTarget.h"
+
+// Frame recording shared by the deferred renderers, which collect everything
+// drawWatchFace() submits and only draw it at present().
+
+typedef void (*SpanFunction)(FrameBuffer& frame, int x, int y, int w, int32_t u, int32_t v, int32_t dudx,
+                             int32_t dvdx, const void *shader);
+
+// Type erased FrameBuffer::shadeSpan() for one shader type, through its
+// texture's sampler.
+template <typename Shader>
+void shadeSpanWith(FrameBuffer& frame, int x, int y, int w, int32_t u, int32_t v, int32_t dudx, int32_t dvdx,
+                   const void *shader)
+{
+    sampleSpan(frame, x, y, w, u, v, dudx, dvdx, *static_cast<const Shader *>(shader));
+}
+
+// Shaders are recorded by address and only run at present(), so they have to
+// outlive the frame. The watch face only uses global constants.
+struct RecordedTriangle
+{
+    RasterVertex v0, v1, v2;   // sorted by y
+    UvGradients gradients;
+    SpanFunction shade;
+    const void *shader;
+};
+
+// Bresenham line in the coordinates of its major axis, set up the same way as
+// Adafruit_GFX::writeLine. draw() plots the part of the line inside a
+// rectangle, exactly the pixels the full walk would plot there, without
+// walking the rest of the line.
+struct RasterLine
+{
+    int16_t start, end;   // major axis, start <= end
+    int16_t minor;        // minor coordinate at start
+    int16_t dMajor, dMinor;
+    int8_t minorStep;
+    bool steep;
+    uint16_t color;
+
+    void init(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t lineColor)
+    {
+        steep = abs(y1 - y0) > abs(x1 - x0);
+
+        if (steep)
+        {
+            int16_t t = x0; x0 = y0; y0 = t;
+            t = x1; x1 = y1; y1 = t;
+        }
+
+        if (x0 > x1)
+        {
+            int16_t t = x0; x0 = x1; x1 = t;
+            t = y0; y0 = y1; y1 = t;
+        }
+
+        start = x0;
+        end = x1;
+        minor = y0;
+        dMajor = x1 - x0;
+        dMinor = abs(y1 - y0);
+        minorStep = y0 < y1 ? 1 : -1;
+        color = lineColor;
+    }
+
+    // Plots the pixels in the inclusive rectangle [x0, x1] x [y0, y1].
+    template <typename Target>
+    void draw(Target& target, int x0, int y0, int x1, int y1) const
+    {
+        int first = steep ? y0 : x0, last = steep ? y1 : x1;
+        int minorLow = steep ? x0 : y0, minorHigh = steep ? x1 : y1;
+
+        // After k steps the walk has moved the minor coordinate
+        // n = ceil((k * dMinor - dMajor / 2) / dMajor) times. Turn the minor
+        // range into the range of steps that stay inside it.
+        int nLow = minorStep > 0 ? minorLow - minor : minor - minorHigh;
+        int nHigh = minorStep > 0 ? minorHigh - minor : minor - minorLow;
+        int32_t e0 = dMajor / 2;
+
+        if (dMinor == 0)
+        {
+            if (nLow > 0 || nHigh < 0)
+                return;
+        }
+        else
+        {
+            int32_t kLow = floorDiv((nLow - 1) * dMajor + e0, dMinor) + 1;
+            int32_t kHigh = floorDiv(nHigh * dMajor + e0, dMinor);
+
+            if (start + kLow > first)
+                first = start + kLow;
+            if (start + kHigh < last)
+                last = start + kHigh;
+        }
+
+        if (first < start)
+            first = start;
+        if (last > end)
+            last = end;
+
+        if (first > last)
+            return;
+
+        int32_t k = first - start;
+        int32_t n = dMajor ? ceilDiv(k * dMinor - e0, dMajor) : 0;
+        int32_t error = e0 - k * dMinor + n * dMajor;
+        int m = minor + n * minorStep;
+
+        for (int major = first; major <= last; major++)
+        {
+            if (steep)
+                target.drawPixel(m, major, color);
+            else
+                target.drawPixel(major, m, color);
+
+            error -= dMinor;
+
+            if (error < 0)
+            {
+                m += minorStep;
+                error += dMajor;
+            }
+        }
+    }
+};
+
+struct Primitive
+{
+    bool isLine;
+#if SPIRAL_BENCHMARK && SPIRAL_OVERDRAW
+    uint8_t mesh;
+#endif
+
+    // Pixels the primitive can touch, inclusive and clamped to the screen.
+    int16_t x0, y0, x1, y1;
+
+    union
+    {
+        RecordedTriangle triangle;
+        RasterLine line;
+    };
+};
+
+template <int Capacity>
+struct PrimitiveList
+{
+    static const int CAPACITY = Capacity;
+
+    Primitive items[Capacity];
+    int count = 0;
+
+    bool full() const { return count == Capacity; }
+    void clear() { count = 0; }
+
+    const Primitive& operator[](int i) const { return items[i]; }
+
+    // Returns false for triangles that cover no pixel centers on screen.
+    template <typename Shader>
+    bool addTriangle(RasterVertex v0, RasterVertex v1, RasterVertex v2, const Shader& shader)
+    {
+        sortByY(v0, v1, v2);
+
+        UvGradients gradients;
+        if (!gradients.init(v0, v1, v2))
+            return false;
+
+        int32_t minX = v0.x < v1.x ? v0.x : v1.x, maxX = v0.x > v1.x ? v0.x : v1.x;
+        minX = v2.x < minX ? v2.x : minX;
+        maxX = v2.x > maxX ? v2.x : maxX;
+
+        // Sorted, so v0 and v2 bound y.
+        int x0 = ceilDiv(minX, SUBPIXEL_ONE), x1 = floorDiv(maxX, SUBPIXEL_ONE);
+        int y0 = ceilDiv(v0.y, SUBPIXEL_ONE), y1 = floorDiv(v2.y, SUBPIXEL_ONE);
+
+        if (x0 > x1 || y0 > y1)
+            return false;
+
+        Primitive &p = add(x0, y0, x1, y1);
+        p.isLine = false;
+        p.triangle.v0 = v0;
+        p.triangle.v1 = v1;
+        p.triangle.v2 = v2;
+        p.triangle.gradients = gradients;
+        p.triangle.shade = &shadeSpanWith<Shader>;
+        p.triangle.shader = &shader;
+        return true;
+    }
+
+    // Returns false for lines entirely off screen.
+    bool addLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+        if ((x0 < 0 && x1 < 0) || (y0 < 0 && y1 < 0) ||
+            (x0 >= SCREEN_WIDTH && x1 >= SCREEN_WIDTH) || (y0 >= SCREEN_HEIGHT && y1 >= SCREEN_HEIGHT))
+            return false;
+
+        Primitive &p = add(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, x0 > x1 ? x0 : x1, y0 > y1 ? y0 : y1);
+        p.isLine = true;
+        p.line.init(x0, y0, x1, y1, color);
+        return true;
+    }
+
+private:
+    Primitive& add(int x0, int y0, int x1, int y1)
+    {
+        Primitive &p = items[count++];
+        p.x0 = constrain(x0, 0, SCREEN_WIDTH - 1);
+        p.y0 = constrain(y0, 0, SCREEN_HEIGHT - 1);
+        p.x1 = constrain(x1, 0, SCREEN_WIDTH - 1);
+        p.y1 = constrain(y1, 0, SCREEN_HEIGHT - 1);
+#if SPIRAL_BENCHMARK && SPIRAL_OVERDRAW
+        p.mesh = renderStats.mesh;
+#endif
+        return p;
+    }
+};
@@ -0,0 +1,767 @@
+#pragma once
+
+#include <Arduino.h>
+#include "RenderConfig.h"
+#include "RenderStats.h"
+#include "Texture.h"
+#include "Sampler.h"
+
+// Vertex positions are snapped to 1/16 pixel. Rasterizer coordinates are shifted
+// by half a pixel, so pixel centers sit on integer positions.
+const int SUBPIXEL_BITS = 4;
+const int32_t SUBPIXEL_ONE = 1 << SUBPIXEL_BITS;
+
+inline int32_t toSubpixel(float v) { return (int32_t)lroundf((v - 0.5f) * SUBPIXEL_ONE); }
+inline int32_t toSubpixel(double v) { return (int32_t)lround((v - 0.5) * SUBPIXEL_ONE); }
+inline int32_t toSubpixel(Fixed v)
+{
+    const int shift = Fixed::FRACTION_BITS - SUBPIXEL_BITS;
+    return (v.raw - (Fixed::ONE >> 1) + (1 << (shift - 1))) >> shift;
+}
+
+// Texture coordinates are stepped as Q16.16 integers.
+inline int32_t toFixedRaw(float v) { return (int32_t)lroundf(v * Fixed::ONE); }
+inline int32_t toFixedRaw(double v) { return (int32_t)lround(v * Fixed::ONE); }
+inline int32_t toFixedRaw(Fixed v) { return v.raw; }
+
+inline int32_t floorDiv(int32_t n, int32_t d)
+{
+    int32_t q = n / d;
+    if (n % d < 0)
+        q--;
+    return q;
+}
+
+inline int32_t ceilDiv(int32_t n, int32_t d)
+{
+    return -floorDiv(-n, d);
+}
+
+// Rounds halves away from zero, like lround().
+inline int32_t roundDiv(int64_t n, int64_t d)
+{
+    if (d < 0)
+    {
+        n = -n;
+        d = -d;
+    }
+
+    return (int32_t)(n >= 0 ? (n + d / 2) / d : -((-n + d / 2) / d));
+}
+
+struct RasterVertex
+{
+    int32_t x, y;
+    int32_t u, v;
+
+    static RasterVertex from(const Vector& position, const Vector& uv)
+    {
+        return {toSubpixel(position.x), toSubpixel(position.y), toFixedRaw(uv.x), toFixedRaw(uv.y)};
+    }
+
+    // For the integer edge walkers, which sample at the pixel coordinates
+    // themselves rather than at pixel centers.
+    static RasterVertex fromPixel(const VectorInt& position, const Vector& uv)
+    {
+        return {position.x * SUBPIXEL_ONE, position.y * SUBPIXEL_ONE, toFixedRaw(uv.x), toFixedRaw(uv.y)};
+    }
+};
+
+// Twice the signed area, negative when v1 lies left of the edge v0-v2.
+inline int32_t triangleArea(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2)
+{
+    return (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+}
+
+// Walks the x intercept of one triangle edge down the pixel rows with an exact
+// integer DDA. x is the first pixel column whose center lies on or right of
+// the edge, so a row covers [left.x, right.x): centers exactly on a left edge
+// are filled, centers exactly on a right edge are not. Together with rows
+// running from ceil(top) to before ceil(bottom) this is the top-left fill
+// rule, under which two triangles sharing an edge never both claim a pixel.
+// Rows outside [yMin, yMax) are skipped without stepping through them.
+struct EdgeWalker
+{
+    int y;
+    int yEnd;
+    int x;
+    int step;
+    int32_t error;
+    int32_t errorStep;
+    int32_t denominator;
+
+    void init(const RasterVertex& a, const RasterVertex& b, int yMin, int yMax)
+    {
+        int32_t dx = b.x - a.x, dy = b.y - a.y;
+
+        y = ceilDiv(a.y, SUBPIXEL_ONE);
+        yEnd = ceilDiv(b.y, SUBPIXEL_ONE);
+
+        if (y < yMin)
+            y = yMin;
+        if (yEnd > yMax)
+            yEnd = yMax;
+
+        if (y >= yEnd)
+            return;
+
+        // Intercept with row y is numerator / denominator pixels.
+        denominator = dy * SUBPIXEL_ONE;
+        int32_t numerator = a.x * dy + (y * SUBPIXEL_ONE - a.y) * dx;
+
+        x = ceilDiv(numerator, denominator);
+        error = x * denominator - numerator;
+
+        step = floorDiv(dx * SUBPIXEL_ONE, denominator);
+        errorStep = dx * SUBPIXEL_ONE - step * denominator;
+    }
+
+    // Returns true when x moved one column further than step.
+    bool advance()
+    {
+        y++;
+        x += step;
+        error -= errorStep;
+
+        if (error < 0)
+        {
+            x++;
+            error += denominator;
+            return true;
+        }
+
+        return false;
+    }
+};
+
+// Edge function in subpixel units, already biased for the top-left rule: a
+// pixel center is inside the triangle when all three are >= 0. Covers the
+// same pixels as the edge walkers.
+struct EdgeFunction
+{
+    int32_t origin;   // at pixel (0, 0)
+    int32_t stepX, stepY;
+
+    int32_t at(int x, int y) const { return origin + x * stepX + y * stepY; }
+
+    void init(const RasterVertex& a, const RasterVertex& b)
+    {
+        int32_t dx = b.x - a.x, dy = b.y - a.y;
+        bool topLeft = dy < 0 || (dy == 0 && dx > 0);
+
+        origin = dy * a.x - dx * a.y - (topLeft ? 0 : 1);
+        stepX = -dy * SUBPIXEL_ONE;
+        stepY = dx * SUBPIXEL_ONE;
+    }
+};
+
+// Edges of a triangle wound so the inside is positive. Pixel centers exactly
+// on an edge only count on left and top edges.
+inline void setupEdgeFunctions(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2,
+                               EdgeFunction *e)
+{
+    if (triangleArea(v0, v1, v2) > 0)
+    {
+        e[0].init(v0, v1);
+        e[1].init(v1, v2);
+        e[2].init(v2, v0);
+    }
+    else
+    {
+        e[0].init(v0, v2);
+        e[1].init(v2, v1);
+        e[2].init(v1, v0);
+    }
+}
+
+// Triangles whose bounds are under 2 pixels both ways, which contain at most
+// 2x2 pixel centers. They skip the full setup: their texture is sampled at a
+// single point and their pixels are tested one by one.
+inline bool isSmallTriangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2)
+{
+    int32_t minX = v0.x < v1.x ? v0.x : v1.x, maxX = v0.x > v1.x ? v0.x : v1.x;
+    int32_t minY = v0.y < v1.y ? v0.y : v1.y, maxY = v0.y > v1.y ? v0.y : v1.y;
+    minX = v2.x < minX ? v2.x : minX;
+    maxX = v2.x > maxX ? v2.x : maxX;
+    minY = v2.y < minY ? v2.y : minY;
+    maxY = v2.y > maxY ? v2.y : maxY;
+
+    return maxX - minX < 2 * SUBPIXEL_ONE && maxY - minY < 2 * SUBPIXEL_ONE;
+}
+
+// Affine texture coordinate planes of a triangle. The plane is evaluated
+// once, at an anchor pixel on screen, and everything else is integer offsets
+// from there, so span kernels that start from evaluate() and add
+// dudx/dvdx per pixel agree exactly however they walk the triangle.
+struct UvGradients
+{
+    int32_t dudx, dvdx;
+    int32_t dudy, dvdy;
+
+    int anchorX, anchorY;
+    int32_t anchorU, anchorV;
+
+    // Returns false for triangles without area, which cover no pixel centers.
+    bool init(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2)
+    {
+        int32_t dx1 = v1.x - v0.x, dy1 = v1.y - v0.y;
+        int32_t dx2 = v2.x - v0.x, dy2 = v2.y - v0.y;
+        int32_t area = triangleArea(v0, v1, v2);
+
+        if (area == 0)
+            return false;
+
+        // The pixel nearest to v0, pulled onto the screen so that the integer
+        // offsets from it stay small.
+        anchorX = constrain(floorDiv(v0.x + SUBPIXEL_ONE / 2, SUBPIXEL_ONE), 0, SCREEN_WIDTH - 1);
+        anchorY = constrain(floorDiv(v0.y + SUBPIXEL_ONE / 2, SUBPIXEL_ONE), 0, SCREEN_HEIGHT - 1);
+
+        // Small triangles are flat, with the texture at their centroid.
+        if (isSmallTriangle(v0, v1, v2))
+        {
+            dudx = dvdx = dudy = dvdy = 0;
+            anchorU = (v0.u + v1.u + v2.u) / 3;
+            anchorV = (v0.v + v1.v + v2.v) / 3;
+            return true;
+        }
+
+        // Q16.16 per subpixel, times the area. Exact in 64 bits, and divided
+        // once with rounding, so every build steps the same planes.
+        int64_t du1 = v1.u - v0.u, dv1 = v1.v - v0.v;
+        int64_t du2 = v2.u - v0.u, dv2 = v2.v - v0.v;
+        int64_t uX = du1 * dy2 - du2 * dy1, vX = dv1 * dy2 - dv2 * dy1;
+        int64_t uY = du2 * dx1 - du1 * dx2, vY = dv2 * dx1 - dv1 * dx2;
+
+        dudx = roundDiv(uX * SUBPIXEL_ONE, area);
+        dvdx = roundDiv(vX * SUBPIXEL_ONE, area);
+        dudy = roundDiv(uY * SUBPIXEL_ONE, area);
+        dvdy = roundDiv(vY * SUBPIXEL_ONE, area);
+
+        int64_t px = anchorX * SUBPIXEL_ONE - v0.x;
+        int64_t py = anchorY * SUBPIXEL_ONE - v0.y;
+        anchorU = v0.u + roundDiv(uX * px + uY * py, area);
+        anchorV = v0.v + roundDiv(vX * px + vY * py, area);
+        return true;
+    }
+
+    void evaluate(int x, int y, int32_t& u, int32_t& v) const
+    {
+        u = anchorU + (x - anchorX) * dudx + (y - anchorY) * dudy;
+        v = anchorV + (x - anchorX) * dvdx + (y - anchorY) * dvdy;
+    }
+};
+
+#ifndef _swap_raster_vertex
+#define _swap_raster_vertex(a, b)                                              \
+  {                                                                            \
+    RasterVertex t = a;                                                        \
+    a = b;                                                                     \
+    b = t;                                                                     \
+  }
+#endif
+
+// Scan order of vertices: top to bottom, and left to right within a row. The
+// order is total, so a triangle is set up the same way whatever order its
+// vertices were submitted in.
+inline bool above(const RasterVertex& a, const RasterVertex& b)
+{
+    return a.y < b.y || (a.y == b.y && a.x < b.x);
+}
+
+// Sorts the vertices into scan order (v0 above v1 above v2). Every renderer
+// sorts before setting up UvGradients, so they all evaluate the same plane.
+inline void sortByY(RasterVertex& v0, RasterVertex& v1, RasterVertex& v2)
+{
+    if (above(v1, v0))
+        _swap_raster_vertex(v0, v1);
+    if (above(v2, v1))
+        _swap_raster_vertex(v2, v1);
+    if (above(v1, v0))
+        _swap_raster_vertex(v0, v1);
+}
+
+// Vertices further than this outside the screen are clipped geometrically
+// before rasterization, which keeps the edge walker products inside 32 bits.
+// Anything closer is left to the per-row and per-span clamping below, which is
+// much cheaper than clipping polygons.
+const int GUARD_BAND = 512;
+
+inline bool insideGuardBand(const RasterVertex& v)
+{
+    const int32_t low = -GUARD_BAND * SUBPIXEL_ONE;
+    return v.x >= low && v.x <= (SCREEN_WIDTH + GUARD_BAND) * SUBPIXEL_ONE &&
+           v.y >= low && v.y <= (SCREEN_HEIGHT + GUARD_BAND) * SUBPIXEL_ONE;
+}
+
+// Outcodes: the sides of the screen a vertex lies beyond, as far as pixel
+// centers go, and whether it lies outside the guard band. A triangle whose
+// vertices share a side misses the screen.
+const uint8_t OUTSIDE_LEFT = 1;
+const uint8_t OUTSIDE_TOP = 2;
+const uint8_t OUTSIDE_RIGHT = 4;
+const uint8_t OUTSIDE_BOTTOM = 8;
+const uint8_t OUTSIDE_SCREEN = OUTSIDE_LEFT | OUTSIDE_TOP | OUTSIDE_RIGHT | OUTSIDE_BOTTOM;
+const uint8_t OUTSIDE_GUARD_BAND = 16;
+
+inline uint8_t outcode(const RasterVertex& v)
+{
+    uint8_t code = 0;
+
+    if (v.x <= 0)
+        code |= OUTSIDE_LEFT;
+    if (v.y <= 0)
+        code |= OUTSIDE_TOP;
+    if (v.x > (SCREEN_WIDTH - 1) * SUBPIXEL_ONE)
+        code |= OUTSIDE_RIGHT;
+    if (v.y > (SCREEN_HEIGHT - 1) * SUBPIXEL_ONE)
+        code |= OUTSIDE_BOTTOM;
+    if (!insideGuardBand(v))
+        code |= OUTSIDE_GUARD_BAND;
+
+    return code;
+}
+
+// One Sutherland-Hodgman step: keeps the part of the polygon where the x
+// (axis 0) or y (axis 1) coordinate, times sign, is at most limit.
+inline int clipPolygon(const RasterVertex* in, int count, RasterVertex* out, int axis, int sign, int32_t limit)
+{
+    int n = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        const RasterVertex& a = in[i];
+        const RasterVertex& b = in[(i + 1) % count];
+        int32_t da = sign * (axis ? a.y : a.x) - limit;
+        int32_t db = sign * (axis ? b.y : b.x) - limit;
+
+        if (da <= 0)
+            out[n++] = a;
+
+        if ((da <= 0) != (db <= 0))
+        {
+            float t = (float)da / (da - db);
+            RasterVertex c;
+            c.x = a.x + lroundf((b.x - a.x) * t);
+            c.y = a.y + lroundf((b.y - a.y) * t);
+            c.u = a.u + lroundf((float)(b.u - a.u) * t);
+            c.v = a.v + lroundf((float)(b.v - a.v) * t);
+            out[n++] = c;
+        }
+    }
+
+    return n;
+}
+
+// Clips a triangle to the guard band. Returns the vertex count of the convex
+// polygon left in out, which needs room for 7 vertices.
+inline int clipToGuardBand(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2, RasterVertex* out)
+{
+    RasterVertex a[8] = {v0, v1, v2}, b[8];
+    const int32_t low = GUARD_BAND * SUBPIXEL_ONE;
+
+    int n = clipPolygon(a, 3, b, 0, -1, low);
+    n = clipPolygon(b, n, a, 0, 1, (SCREEN_WIDTH + GUARD_BAND) * SUBPIXEL_ONE);
+    n = clipPolygon(a, n, b, 1, -1, low);
+    n = clipPolygon(b, n, out, 1, 1, (SCREEN_HEIGHT + GUARD_BAND) * SUBPIXEL_ONE);
+    return n;
+}
+
+// Moves the texture coordinates of a triangle onto the level of a mip chain
+// whose texels come closest to one per pixel: log4 of the texel area its
+// mapping gives each pixel, rounded. An affine mapping has the same ratio
+// everywhere, so the pieces of a clipped triangle pick the same level.
+inline void selectMipLevel(const MipChain& mips, RasterVertex& v0, RasterVertex& v1, RasterVertex& v2)
+{
+    int32_t area = triangleArea(v0, v1, v2);
+    if (area == 0)
+        return;
+
+    // Q16.16 texels squared over subpixels squared, both areas doubled.
+    const float SCALE = (float)(SUBPIXEL_ONE * SUBPIXEL_ONE) / ((float)Fixed::ONE * Fixed::ONE);
+    float du1 = v1.u - v0.u, dv1 = v1.v - v0.v;
+    float du2 = v2.u - v0.u, dv2 = v2.v - v0.v;
+    float ratio = fabsf((du1 * dv2 - du2 * dv1) / area) * SCALE;
+
+    int level = 0;
+
+    for (; level < mips.levels - 1 && ratio >= 2; level++)
+        ratio *= 0.25f;
+
+    RENDER_STAT(mipTriangles[level], 1);
+
+    if (level == 0)
+        return;
+
+    // The sampler moves the spans to the level in the atlas.
+    RasterVertex *vertices[3] = {&v0, &v1, &v2};
+
+    for (int i = 0; i < 3; i++)
+    {
+        vertices[i]->u = (vertices[i]->u >> level) + level * (MipChain::LEVEL_SPACING << Fixed::FRACTION_BITS);
+        vertices[i]->v = vertices[i]->v >> level;
+    }
+}
+
+template <typename Target, typename Shader>
+void scanTriangle(Target& target, RasterVertex v0, RasterVertex v1, RasterVertex v2, const Shader& shader);
+
+// Fills the pixels whose centers lie inside the triangle, running shader on
+// each of them. Target is one of the render targets in RenderTarget.h.
+// Triangles that miss the screen are dropped here and the rest is clipped to
+// the guard band and moved onto its mip level, if the texture has mips,
+// before it goes on to scanTriangle(). Deferred renderers
+// overload scanTriangle() for their own target type to record the triangle
+// instead of scanning it.
+template <typename Target, typename Shader>
+void rasterizeTriangle(Target& target, RasterVertex v0, RasterVertex v1, RasterVertex v2, const Shader& shader)
+{
+    RENDER_STAT(triangles, 1);
+
+    uint8_t c0 = outcode(v0), c1 = outcode(v1), c2 = outcode(v2);
+
+    // Trivially reject triangles whose bounds miss every pixel center on screen.
+    if (c0 & c1 & c2 & OUTSIDE_SCREEN)
+    {
+        RENDER_STAT(culledTriangles, 1);
+        return;
+    }
+
+    if ((c0 | c1 | c2) & OUTSIDE_GUARD_BAND)
+    {
+        RENDER_STAT(guardBandClips, 1);
+
+        RasterVertex polygon[8];
+        int count = clipToGuardBand(v0, v1, v2, polygon);
+
+        for (int i = 2; i < count; i++)
+            rasterizeTriangle(target, polygon[0], polygon[i - 1], polygon[i], shader);
+
+        return;
+    }
+
+    if (const MipChain *mips = mipChain(shader))
+        selectMipLevel(*mips, v0, v1, v2);
+
+    scanTriangle(target, v0, v1, v2, shader);
+}
+
+// Walks the rows of a sorted triangle between its long edge v0-v2 and its
+// short edges v0-v1 (upper) and v1-v2 (lower), all set up with the full screen
+// as row range, and hands each row's span to the target.
+template <typename Target, typename Shader>
+void scanEdges(Target& target, const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2,
+               const UvGradients& gradients, EdgeWalker& longEdge, EdgeWalker& upperEdge, EdgeWalker& lowerEdge,
+               const Shader& shader)
+{
+    // The long edge bounds one side of every row, the short edges the other.
+    bool middleLeft = triangleArea(v0, v1, v2) < 0;
+
+    RENDER_STAT(clippedRows, (ceilDiv(v2.y, SUBPIXEL_ONE) - ceilDiv(v0.y, SUBPIXEL_ONE)) -
+                             (longEdge.yEnd - longEdge.y));
+
+    target.startWrite();
+
+    for (int half = 0; half < 2; half++)
+    {
+        EdgeWalker &shortEdge = half == 0 ? upperEdge : lowerEdge;
+
+        if (shortEdge.y >= shortEdge.yEnd)
+            continue;
+
+        EdgeWalker &left = middleLeft ? shortEdge : longEdge;
+        EdgeWalker &right = middleLeft ? longEdge : shortEdge;
+
+        // Texture coordinates follow the left edge down with adds only: one row
+        // down plus either step or step + 1 columns across.
+        int32_t u, v;
+        gradients.evaluate(left.x, left.y, u, v);
+
+        int32_t uStep = gradients.dudy + left.step * gradients.dudx;
+        int32_t vStep = gradients.dvdy + left.step * gradients.dvdx;
+
+        while (shortEdge.y < shortEdge.yEnd)
+        {
+            // Clamp the span to the screen, moving its texture coordinates along.
+            int x = left.x, end = right.x;
+            int32_t spanU = u, spanV = v;
+
+            if (x < 0)
+            {
+                RENDER_STAT(clippedPixels, (end < 0 ? end : 0) - x);
+                spanU -= x * gradients.dudx;
+                spanV -= x * gradients.dvdx;
+                x = 0;
+            }
+
+            if (end > SCREEN_WIDTH)
+            {
+                RENDER_STAT(clippedPixels, end - (x > SCREEN_WIDTH ? x : SCREEN_WIDTH));
+                end = SCREEN_WIDTH;
+            }
+
+            if (end > x)
+            {
+                RENDER_STAT(shadedPixels, end - x);
+                RENDER_OVERDRAW(x, shortEdge.y, end - x);
+                sampleSpan(target, x, shortEdge.y, end - x, spanU, spanV, gradients.dudx, gradients.dvdx, shader);
+            }
+
+            bool carry = left.advance();
+            right.advance();
+
+            u += uStep;
+            v += vStep;
+
+            if (carry)
+            {
+                u += gradients.dudx;
+                v += gradients.dvdx;
+            }
+        }
+    }
+
+    target.endWrite();
+}
+
+// Shades the pixel centers of a small triangle, at most 2x2 of them, testing
+// each against the edge functions instead of setting up edge walkers.
+template <typename Target, typename Shader>
+void pointSampleTriangle(Target& target, const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2,
+                         const UvGradients& gradients, const Shader& shader)
+{
+    RENDER_STAT(smallTriangles, 1);
+
+    EdgeFunction edges[3];
+    setupEdgeFunctions(v0, v1, v2, edges);
+
+    int32_t minX = v0.x < v1.x ? v0.x : v1.x, maxX = v0.x > v1.x ? v0.x : v1.x;
+    minX = v2.x < minX ? v2.x : minX;
+    maxX = v2.x > maxX ? v2.x : maxX;
+
+    // Sorted, so v0 and v2 bound y.
+    int x0 = ceilDiv(minX, SUBPIXEL_ONE), x1 = floorDiv(maxX, SUBPIXEL_ONE);
+    int y0 = ceilDiv(v0.y, SUBPIXEL_ONE), y1 = floorDiv(v2.y, SUBPIXEL_ONE);
+
+    x0 = x0 < 0 ? 0 : x0;
+    y0 = y0 < 0 ? 0 : y0;
+    x1 = x1 > SCREEN_WIDTH - 1 ? SCREEN_WIDTH - 1 : x1;
+    y1 = y1 > SCREEN_HEIGHT - 1 ? SCREEN_HEIGHT - 1 : y1;
+
+    target.startWrite();
+
+    for (int y = y0; y <= y1; y++)
+    {
+        int start = x1 + 1, end = x0;
+
+        for (int x = x0; x <= x1; x++)
+        {
+            if ((edges[0].at(x, y) | edges[1].at(x, y) | edges[2].at(x, y)) >= 0)
+            {
+                if (start > x1)
+                    start = x;
+                end = x + 1;
+            }
+        }
+
+        if (start < end)
+        {
+            int32_t u, v;
+            gradients.evaluate(start, y, u, v);
+
+            RENDER_STAT(shadedPixels, end - start);
+            RENDER_OVERDRAW(start, y, end - start);
+            sampleSpan(target, start, y, end - start, u, v, gradients.dudx, gradients.dvdx, shader);
+        }
+    }
+
+    target.endWrite();
+}
+
+// Scan converts a triangle row by row with the edge walkers.
+template <typename Target, typename Shader>
+void scanTriangle(Target& target, RasterVertex v0, RasterVertex v1, RasterVertex v2, const Shader& shader)
+{
+    sortByY(v0, v1, v2);
+
+    // Triangles without area cover no pixel centers. They are rejected before
+    // anything divides.
+    UvGradients gradients;
+    if (!gradients.init(v0, v1, v2))
+    {
+        RENDER_STAT(zeroAreaTriangles, 1);
+        return;
+    }
+
+    if (isSmallTriangle(v0, v1, v2))
+    {
+        pointSampleTriangle(target, v0, v1, v2, gradients, shader);
+        return;
+    }
+
+    RENDER_STAT(scannedTriangles, 1);
+
+    EdgeWalker longEdge, upperEdge, lowerEdge;
+    longEdge.init(v0, v2, 0, SCREEN_HEIGHT);
+    upperEdge.init(v0, v1, 0, SCREEN_HEIGHT);
+    lowerEdge.init(v1, v2, 0, SCREEN_HEIGHT);
+    RENDER_STAT(edgeSetups, 3);
+
+    scanEdges(target, v0, v1, v2, gradients, longEdge, upperEdge, lowerEdge, shader);
+}
+
+// Sets up the edge between two vertices in either order, walking it top to
+// bottom.
+inline void setupEdge(EdgeWalker& edge, const RasterVertex& a, const RasterVertex& b)
+{
+    RENDER_STAT(edgeSetups, 1);
+
+    if (above(a, b))
+        edge.init(a, b, 0, SCREEN_HEIGHT);
+    else
+        edge.init(b, a, 0, SCREEN_HEIGHT);
+}
+
+// Edge setup a triangle strip hands from one triangle to the next.
+struct StripEdges
+{
+    EdgeWalker shared;   // between the two newest vertices, not walked yet
+    bool valid;
+};
+
+// Scans the strip triangle v[0], v[1], v[2]. Its edge v[0]-v[1] is taken
+// from edges when the previous triangle set it up, and its edge v[1]-v[2] is
+// left there for the next one. Renders exactly like scanTriangle().
+template <typename Target, typename Shader>
+void scanStripTriangle(Target& target, StripEdges& edges, const RasterVertex* v, const Shader& shader)
+{
+    bool reuse = edges.valid;
+    edges.valid = false;
+
+    // Vertex indices in the order sortByY() puts the vertices in.
+    int i0 = 0, i1 = 1, i2 = 2, t;
+
+    if (above(v[i1], v[i0]))
+    {
+        t = i0; i0 = i1; i1 = t;
+    }
+    if (above(v[i2], v[i1]))
+    {
+        t = i1; i1 = i2; i2 = t;
+    }
+    if (above(v[i1], v[i0]))
+    {
+        t = i0; i0 = i1; i1 = t;
+    }
+
+    UvGradients gradients;
+    if (!gradients.init(v[i0], v[i1], v[i2]))
+    {
+        RENDER_STAT(zeroAreaTriangles, 1);
+        return;
+    }
+
+    if (isSmallTriangle(v[0], v[1], v[2]))
+    {
+        pointSampleTriangle(target, v[i0], v[i1], v[i2], gradients, shader);
+        return;
+    }
+
+    RENDER_STAT(scannedTriangles, 1);
+
+    // edge[i] is the edge opposite vertex i.
+    EdgeWalker edge[3];
+
+    if (reuse)
+    {
+        edge[2] = edges.shared;
+        RENDER_STAT(sharedEdges, 1);
+    }
+    else
+    {
+        setupEdge(edge[2], v[0], v[1]);
+    }
+
+    setupEdge(edge[0], v[1], v[2]);
+    setupEdge(edge[1], v[0], v[2]);
+
+    edges.shared = edge[0];
+    edges.valid = true;
+
+    scanEdges(target, v[i0], v[i1], v[i2], gradients, edge[i1], edge[i2], edge[i0], shader);
+}
+
+// Rasterizes a triangle strip as its vertices come in: from the third vertex
+// on, every vertex completes a triangle with the two before it. Each vertex
+// is snapped and classified against the screen once rather than once per
+// triangle, and the edge two neighbouring triangles share is set up once.
+// Deferred renderers overload scanStripTriangle() to record the triangles.
+template <typename Target, typename Shader>
+struct TriangleStrip
+{
+    Target& target;
+    const Shader& shader;
+
+    RasterVertex vertices[3];   // the newest last
+    uint8_t outcodes[3];
+    int count;
+    StripEdges edges;
+
+    TriangleStrip(Target& target, const Shader& shader)
+        : target(target), shader(shader), vertices(), outcodes(), count(0)
+    {
+        edges.valid = false;
+    }
+
+    void add(const Vector& position, const Vector& uv)
+    {
+        add(RasterVertex::from(position, uv));
+    }
+
+    void add(const RasterVertex& vertex)
+    {
+        RENDER_STAT(stripVertices, 1);
+
+        vertices[0] = vertices[1];
+        vertices[1] = vertices[2];
+        vertices[2] = vertex;
+        outcodes[0] = outcodes[1];
+        outcodes[1] = outcodes[2];
+        outcodes[2] = outcode(vertex);
+
+        if (count < 3)
+            count++;
+        if (count < 3)
+            return;
+
+        RENDER_STAT(stripTriangles, 1);
+
+        if (outcodes[0] & outcodes[1] & outcodes[2] & OUTSIDE_SCREEN)
+        {
+            RENDER_STAT(triangles, 1);
+            RENDER_STAT(culledTriangles, 1);
+            edges.valid = false;
+            return;
+        }
+
+        // Clipped triangles share no edges with their neighbours.
+        if ((outcodes[0] | outcodes[1] | outcodes[2]) & OUTSIDE_GUARD_BAND)
+        {
+            edges.valid = false;
+            rasterizeTriangle(target, vertices[0], vertices[1], vertices[2], shader);
+            return;
+        }
+
+        RENDER_STAT(triangles, 1);
+
+        // Only the texture coordinates change, the shared edges stay valid.
+        if (const MipChain *mips = mipChain(shader))
+        {
+            RasterVertex mipped[3] = {vertices[0], vertices[1], vertices[2]};
+            selectMipLevel(*mips, mipped[0], mipped[1], mipped[2]);
+            scanStripTriangle(target, edges, mipped, shader);
+            return;
+        }
+
+        scanStripTriangle(target, edges, vertices, shader);
+    }
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "Vec2.h"
+
+const int SCREEN_WIDTH = 200;
+const int SCREEN_HEIGHT = 200;
+
+// Scalar type used by the watch face geometry and the rasterizer. Select one
+// with -DSPIRAL_PRECISION=... in the build_flags of platformio.ini.
+#define SPIRAL_PRECISION_DOUBLE 0
+#define SPIRAL_PRECISION_FLOAT 1
+#define SPIRAL_PRECISION_FIXED 2
+
+#ifndef SPIRAL_PRECISION
+#define SPIRAL_PRECISION SPIRAL_PRECISION_FLOAT
+#endif
+
+#if SPIRAL_PRECISION == SPIRAL_PRECISION_DOUBLE
+typedef double Real;
+#elif SPIRAL_PRECISION == SPIRAL_PRECISION_FLOAT
+typedef float Real;
+#elif SPIRAL_PRECISION == SPIRAL_PRECISION_FIXED
+typedef Fixed Real;
+#else
+#error "Unknown SPIRAL_PRECISION"
+#endif
+
+typedef Vec2<Real> Vector;
+typedef Vec2<int> VectorInt;
+
+// Render into a packed 1 bit frame buffer and hand the finished frame to the
+// display once, instead of calling display.drawPixel() for every pixel.
+#ifndef SPIRAL_DIRECT_FRAMEBUFFER
+#define SPIRAL_DIRECT_FRAMEBUFFER 1
+#endif
+
+// Renders a fixed sweep of times on boot and prints the average frame time to
+// the serial monitor, so the precision modes can be compared on the same input.
+#ifndef SPIRAL_BENCHMARK
+#define SPIRAL_BENCHMARK 0
+#endif
+
+// Immediate mode scans every triangle into the target as soon as it is drawn.
+// The deferred modes record the whole frame first and always render into the
+// frame buffer: tiled draws it 8x8 pixels at a time (TileRenderer.h), scanline
+// in one top to bottom sweep (ScanlineRenderer.h). The visibility buffer
+// scans immediately but defers texturing to one pass over the finished frame
+// (VisibilityBuffer.h), the intensity buffer only defers the dithering
+// (IntensityBuffer.h).
+#define SPIRAL_RENDERER_IMMEDIATE 0
+#define SPIRAL_RENDERER_TILED 1
+#define SPIRAL_RENDERER_SCANLINE 2
+#define SPIRAL_RENDERER_VISIBILITY 3
+#define SPIRAL_RENDERER_INTENSITY 4
+
+#ifndef SPIRAL_RENDERER
+#define SPIRAL_RENDERER SPIRAL_RENDERER_IMMEDIATE
+#endif
+
+// How the spiral face and rim are filled: as triangle strips, or each band as
+// one non-zero winding polygon (PolygonFiller.h) whose texture coordinates
+// are computed per span. Polygons are only drawn by the renderers that scan
+// immediately, not by the tiled or scanline ones.
+#define SPIRAL_BANDS_TRIANGLES 0
+#define SPIRAL_BANDS_POLYGONS 1
+
+#ifndef SPIRAL_BANDS
+#define SPIRAL_BANDS SPIRAL_BANDS_TRIANGLES
+#endif
+
+#if SPIRAL_BANDS == SPIRAL_BANDS_POLYGONS && \
+    (SPIRAL_RENDERER == SPIRAL_RENDERER_TILED || SPIRAL_RENDERER == SPIRAL_RENDERER_SCANLINE)
+#error "SPIRAL_BANDS_POLYGONS does not work with the tiled or scanline renderer"
+#endif
+
+// Draws the hands and the center square first and lets the spiral behind
+// them skip the pixels they cover, instead of painting back to front. Needs
+// the packed frame buffer of the immediate renderer for its coverage bits.
+#ifndef SPIRAL_FRONT_TO_BACK
+#define SPIRAL_FRONT_TO_BACK 0
+#endif
+
+#if SPIRAL_FRONT_TO_BACK && (SPIRAL_RENDERER != SPIRAL_RENDERER_IMMEDIATE || !SPIRAL_DIRECT_FRAMEBUFFER)
+#error "SPIRAL_FRONT_TO_BACK needs SPIRAL_RENDERER_IMMEDIATE and SPIRAL_DIRECT_FRAMEBUFFER"
+#endif
+
+// Settles whole frame buffer bytes without fetching a texel wherever the
+// min/max pyramid of the texture (AssetCompiler --minmax) shows that all the
+// texels a byte reads are above every noise value of the byte, or that none
+// are. Textures without a pyramid are always shaded pixel by pixel.
+#ifndef SPIRAL_DITHER_BOUNDS
+#define SPIRAL_DITHER_BOUNDS 0
+#endif
+
+// How the face, rim and center shadow textures are stored: 8 bits per texel,
+// or 4 bit palettized (AssetCompiler --palette4), which halves their flash and
+// the bytes each frame reads from it, but quantizes them to 16 gray levels.
+// Palettized textures have no min/max pyramid for SPIRAL_DITHER_BOUNDS.
+#define SPIRAL_TEXTURE_GRAY8 0
+#define SPIRAL_TEXTURE_PALETTE4 1
+
+#ifndef SPIRAL_TEXTURE_FORMAT
+#define SPIRAL_TEXTURE_FORMAT SPIRAL_TEXTURE_GRAY8
+#endif
+
+// Samples the face and rim textures from mip chains (AssetCompiler --mips),
+// at a level picked per triangle from how many texels each of its pixels
+// covers, so the small inner turns of the spiral read small levels. Only for
+// 8 bit textures, and not for polygon bands, whose mapping is per span.
+#ifndef SPIRAL_MIPMAPS
+#define SPIRAL_MIPMAPS 0
+#endif
+
+#if SPIRAL_MIPMAPS && SPIRAL_TEXTURE_FORMAT != SPIRAL_TEXTURE_GRAY8
+#error "SPIRAL_MIPMAPS needs SPIRAL_TEXTURE_GRAY8"
+#endif
+
+// Texel order of the face texture, which the spiral walks diagonally
+// (Texture.h): row major, rows padded to a power of two, 4x4 or 8x8 tiles,
+// or Morton order, as AssetCompiler --padded, --tiled4, --tiled8 and --morton
+// write them. Mip chains, palettes and the x86 span kernels are row major
+// only.
+#define SPIRAL_LAYOUT_ROWS 0
+#define SPIRAL_LAYOUT_PADDED 1
+#define SPIRAL_LAYOUT_TILED4 2
+#define SPIRAL_LAYOUT_TILED8 3
+#define SPIRAL_LAYOUT_MORTON 4
+
+#ifndef SPIRAL_TEXTURE_LAYOUT
+#define SPIRAL_TEXTURE_LAYOUT SPIRAL_LAYOUT_ROWS
+#endif
+
+#if SPIRAL_TEXTURE_LAYOUT != SPIRAL_LAYOUT_ROWS && (SPIRAL_MIPMAPS || SPIRAL_TEXTURE_FORMAT != SPIRAL_TEXTURE_GRAY8)
+#error "SPIRAL_TEXTURE_LAYOUT needs 8 bit textures without SPIRAL_MIPMAPS"
+#endif
+
+// What spans reading past the edge of their texture do (Sampler.h): clamp to
+// the edge texels, wrap around, or leave the pixels outside untouched. Spans
+// inside the texture, nearly all of them, are checked once and shaded
+// without further checks. SPIRAL_ADDRESS_NONE skips the check and reads
+// wherever the coordinates point.
+#define SPIRAL_ADDRESS_NONE 0
+#define SPIRAL_ADDRESS_CLAMP 1
+#define SPIRAL_ADDRESS_WRAP 2
+#define SPIRAL_ADDRESS_BORDER 3
+
+#ifndef SPIRAL_TEXTURE_ADDRESS
+#define SPIRAL_TEXTURE_ADDRESS SPIRAL_ADDRESS_CLAMP
+#endif
+
+// Reads the textures on the pack line of assets/Textures.txt from a data
+// partition of their own, mapped through the flash cache by mapTextures()
+// (TexturePartition.cpp), instead of linking them into the app image. The
+// partition is flashed separately, so the app gets smaller and textures can
+// change without a rebuild. Set it in build_flags: src/Textures.S
+// checks it without including this file.
+#ifndef SPIRAL_TEXTURE_PARTITION
+#define SPIRAL_TEXTURE_PARTITION 0
+#endif
+
+// Kernels for the dither and threshold stage, which compare texels with the
+// blue noise a frame buffer byte or more at a time: one compare per pixel,
+// four pixels per 32 bit word, or 16 pixels per 128 bit vector with the PIE
+// instructions of the ESP32-S3 (Simd.h). SWAR is the default on every chip;
+// PIE stays opt in until watchy_bench_s3, which asks for it, has reported its
+// kernel check "identical" on the hardware. Host builds may pick any of them
+// to check one against another; there the vector instructions run as plain C.
+#define SPIRAL_KERNEL_SCALAR 0
+#define SPIRAL_KERNEL_SWAR 1
+#define SPIRAL_KERNEL_PIE 2
+
+#ifndef SPIRAL_KERNEL
+#define SPIRAL_KERNEL SPIRAL_KERNEL_SWAR
+#endif
+
+#if SPIRAL_KERNEL == SPIRAL_KERNEL_PIE && defined(__XTENSA__) && !defined(CONFIG_IDF_TARGET_ESP32S3)
+#error "SPIRAL_KERNEL_PIE needs an ESP32-S3"
+#endif
+
+// Highest vector instruction set x86 builds may pick at run time (Simd.h),
+// with the default SPIRAL_KERNEL_SWAR. The ESP32 never uses them.
+#define SPIRAL_SIMD_NONE 0
+#define SPIRAL_SIMD_SSE2 1
+#define SPIRAL_SIMD_AVX2 2
+
+#ifndef SPIRAL_SIMD
+#define SPIRAL_SIMD SPIRAL_SIMD_AVX2
+#endif
+
+// Makes the benchmark also run every texture read through a model of the
+// ESP32 flash cache and count the misses. The x86 kernels read textures
+// without going through the model, so it turns them off.
+#ifndef SPIRAL_CACHE_MODEL
+#define SPIRAL_CACHE_MODEL 0
+#endif
+
+// Makes the benchmark also count, over every minute of the day, pixels that
+// one mesh covers more than once and shader runs on pixels that are drawn
+// over later. Needs two 40 KB buffers, so it is meant for host builds.
+#ifndef SPIRAL_OVERDRAW
+#define SPIRAL_OVERDRAW 0
+#endif
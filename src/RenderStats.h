@@ -0,0 +1,140 @@
+#pragma once
+
+#include <Arduino.h>
+#include "RenderConfig.h"
+
+// Counters filled in by the rasterizer for SPIRAL_BENCHMARK builds. Other
+// builds compile RENDER_STAT away.
+#if SPIRAL_BENCHMARK
+// The modelled flash cache: 32 KB, 2 way set associative, 32 byte lines,
+// least recently used line replaced.
+const int CACHE_LINE = 32;
+const int CACHE_WAYS = 2;
+const int CACHE_SETS = 32768 / CACHE_LINE / CACHE_WAYS;
+
+struct RenderStats
+{
+    uint32_t triangles;
+    uint32_t culledTriangles;   // entirely off screen, rejected before setup
+    uint32_t guardBandClips;    // clipped geometrically to the guard band
+    uint32_t clippedRows;       // triangle rows above or below the screen
+    uint32_t clippedPixels;     // span pixels left or right of the screen
+    uint32_t addressedSpans;    // spans reaching past the texture, cut up by the sampler
+    uint32_t shadedPixels;
+    uint32_t runPixels;         // settled by texture and noise bounds, no texel fetched
+    uint32_t occludedPixels;    // span pixels skipped as covered by a layer in front
+    uint32_t overdrawnPixels;   // pixels a mesh covered more than once
+    uint32_t edgeSetups;        // edge walkers set up by immediate scanning
+
+    // What became of the triangles immediate mode set up.
+    uint32_t scannedTriangles;   // walked with edge walkers
+    uint32_t smallTriangles;     // under 2x2 pixels, point sampled
+    uint32_t zeroAreaTriangles;  // rejected before any division
+
+    // Triangle strips.
+    uint32_t stripTriangles;
+    uint32_t stripVertices;     // snapped and classified once each
+    uint32_t sharedEdges;       // edge setups taken over from the previous triangle
+
+    // Polygon bands only.
+    uint32_t polygonEdges;
+    uint32_t polygonSpans;
+
+    // Tiled renderer only.
+    uint32_t tileBlocksFull;     // 8x8 blocks filled without edge tests
+    uint32_t tileBlocksPartial;  // 8x8 blocks tested pixel by pixel
+    uint32_t tileBlocksEmpty;    // binned blocks the triangle misses
+    uint32_t tileFlushes;        // extra passes because the bins were full
+
+    // Scanline renderer only.
+    uint32_t scanlineSweeps;     // top to bottom passes over the frame
+
+    // Visibility buffer only.
+    uint32_t resolvedPixels;     // texels fetched by the resolve pass
+
+    // Triangles per mip level, with SPIRAL_MIPMAPS.
+    uint32_t mipTriangles[8];
+
+#if SPIRAL_CACHE_MODEL
+    uint32_t textureFetches;     // texel and pyramid reads
+    uint32_t cacheMisses;        // of those, missing the modelled cache
+    uintptr_t cacheTags[CACHE_SETS][CACHE_WAYS];   // most recently used first
+#endif
+
+#if SPIRAL_OVERDRAW
+    uint8_t mesh;
+    uint8_t owner[SCREEN_WIDTH * SCREEN_HEIGHT];
+    uint8_t shaderRuns[SCREEN_WIDTH * SCREEN_HEIGHT];
+#endif
+};
+
+extern RenderStats renderStats;
+
+#define RENDER_STAT(name, n) (renderStats.name += (n))
+#else
+#define RENDER_STAT(name, n)
+#endif
+
+#if SPIRAL_BENCHMARK && SPIRAL_CACHE_MODEL
+// Looks up the line of a texture read in the modelled cache. Tags are line
+// numbers plus one, so the empty tag never matches.
+inline void countFetch(const void *p)
+{
+    uintptr_t tag = (uintptr_t)p / CACHE_LINE + 1;
+    uintptr_t *set = renderStats.cacheTags[tag % CACHE_SETS];
+
+    int way = 0;
+
+    while (way < CACHE_WAYS - 1 && set[way] != tag)
+        way++;
+
+    renderStats.textureFetches++;
+    if (set[way] != tag)
+        renderStats.cacheMisses++;
+
+    for (; way > 0; way--)
+        set[way] = set[way - 1];
+
+    set[0] = tag;
+}
+
+#define RENDER_FETCH(p) countFetch(p)
+#else
+#define RENDER_FETCH(p)
+#endif
+
+#if SPIRAL_BENCHMARK && SPIRAL_OVERDRAW
+// Remembers which mesh last covered each pixel. The meshes of the watch face do
+// not overlap themselves, so a pixel covered twice by the same mesh lies on an
+// edge that two of its triangles both claimed.
+inline void countOverdraw(int x, int y, int w)
+{
+    uint8_t *owner = renderStats.owner + y * SCREEN_WIDTH + x;
+
+    for (int i = 0; i < w; i++)
+    {
+        if (owner[i] == renderStats.mesh)
+            renderStats.overdrawnPixels++;
+
+        owner[i] = renderStats.mesh;
+    }
+}
+
+// Counts shader runs per pixel, across all layers of the frame. Every run
+// after the first on a pixel is wasted on something drawn over later.
+inline void countShaded(int x, int y)
+{
+    uint8_t &runs = renderStats.shaderRuns[y * SCREEN_WIDTH + x];
+
+    if (runs < 255)
+        runs++;
+}
+
+#define RENDER_MESH(id) (renderStats.mesh = (id))
+#define RENDER_OVERDRAW(x, y, w) countOverdraw(x, y, w)
+#define RENDER_SHADED(x, y) countShaded(x, y)
+#else
+#define RENDER_MESH(id)
+#define RENDER_OVERDRAW(x, y, w)
+#define RENDER_SHADED(x, y)
+#endif
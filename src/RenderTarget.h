@@ -0,0 +1,273 @@
+#pragma once
+
+#include <Watchy.h>
+#include "RenderConfig.h"
+#include "RenderStats.h"
+#include "Shaders.h"
+
+// Render targets take whole spans from the rasterizer and the outline strokes
+// from the watch face. The rasterizer only needs startWrite(), endWrite() and
+// shadeSpan(), which runs the pixel shader over one row segment that has
+// already been clipped to the screen.
+
+// Draws straight into the display through drawPixel(), one pixel at a time.
+struct DisplayTarget
+{
+    void startWrite() { Watchy::display.startWrite(); }
+    void endWrite() { Watchy::display.endWrite(); }
+
+    void fill(uint16_t color) { Watchy::display.fillScreen(color); }
+
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+        Watchy::display.drawLine(x0, y0, x1, y1, color);
+    }
+
+    template <typename Shader>
+    void shadeSpan(int x, int y, int w, int32_t u, int32_t v, int32_t dudx, int32_t dvdx, const Shader& shader)
+    {
+        for (int end = x + w; x < end; x++)
+        {
+            uint16_t color;
+
+            RENDER_SHADED(x, y);
+
+            if (shader(x, y, u >> Fixed::FRACTION_BITS, v >> Fixed::FRACTION_BITS, color))
+                Watchy::display.drawPixel(x, y, color);
+
+            u += dudx;
+            v += dvdx;
+        }
+    }
+
+    void present() {}
+};
+
+// Packed 1 bit frame buffer in the layout of the GxEPD2 display buffer: 25
+// bytes per row, leftmost pixel in the most significant bit, set bits white.
+// Spans gather 8 shaded pixels into a byte and store it in one go, with a
+// masked read-modify-write only where a span starts or ends mid-byte.
+struct FrameBuffer
+{
+    static const int STRIDE = SCREEN_WIDTH / 8;
+
+    uint8_t bytes[STRIDE * SCREEN_HEIGHT];
+
+#if SPIRAL_FRONT_TO_BACK
+    // One bit per pixel that a layer drawn earlier, in front, has claimed.
+    // Everything skips claimed pixels without running the shader, whole
+    // bytes at a time where it can. While claiming is set, the pixels drawn
+    // are claimed in turn; pixels a shader leaves untouched are not.
+    uint8_t coverage[STRIDE * SCREEN_HEIGHT];
+    bool claiming;
+#endif
+
+    void startWrite() {}
+    void endWrite() {}
+
+    void fill(uint16_t color)
+    {
+        memset(bytes, color == GxEPD_BLACK ? 0x00 : 0xFF, sizeof(bytes));
+
+#if SPIRAL_FRONT_TO_BACK
+        memset(coverage, 0, sizeof(coverage));
+        claiming = false;
+#endif
+    }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color)
+    {
+        if (x < 0 || x >= SCREEN_WIDTH || y < 0 || y >= SCREEN_HEIGHT)
+            return;
+
+        int offset = y * STRIDE + (x >> 3);
+        uint8_t bit = 0x80 >> (x & 7);
+
+#if SPIRAL_FRONT_TO_BACK
+        if (coverage[offset] & bit)
+            return;
+
+        if (claiming)
+            coverage[offset] |= bit;
+#endif
+
+        store(bytes + offset, color ? bit : 0, bit);
+    }
+
+    // Same Bresenham walk as Adafruit_GFX::writeLine, so outlines match the
+    // display path pixel for pixel.
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+        bool steep = abs(y1 - y0) > abs(x1 - x0);
+
+        if (steep)
+        {
+            int16_t t = x0; x0 = y0; y0 = t;
+            t = x1; x1 = y1; y1 = t;
+        }
+
+        if (x0 > x1)
+        {
+            int16_t t = x0; x0 = x1; x1 = t;
+            t = y0; y0 = y1; y1 = t;
+        }
+
+        int16_t dx = x1 - x0;
+        int16_t dy = abs(y1 - y0);
+        int16_t err = dx / 2;
+        int16_t ystep = y0 < y1 ? 1 : -1;
+
+        for (; x0 <= x1; x0++)
+        {
+            if (steep)
+                drawPixel(y0, x0, color);
+            else
+                drawPixel(x0, y0, color);
+
+            err -= dy;
+
+            if (err < 0)
+            {
+                y0 += ystep;
+                err += dx;
+            }
+        }
+    }
+
+    template <typename Shader>
+    void shadeSpan(int x, int y, int w, int32_t u, int32_t v, int32_t dudx, int32_t dvdx, const Shader& shader)
+    {
+        int end = x + w;
+        uint8_t *row = bytes + y * STRIDE;
+
+        while (x < end)
+        {
+#if !SPIRAL_FRONT_TO_BACK
+            // Runs of at least two whole bytes go to the vector kernels.
+            if ((x & 7) == 0 && end - x >= 16)
+            {
+                int done = shadeBytes(shader, x, y, u, v, dudx, dvdx, row + (x >> 3), (end - x) >> 3);
+
+                for (int i = 0; i < done * 8; i++)
+                    RENDER_SHADED(x + i, y);
+
+                x += done * 8;
+                u += done * 8 * dudx;
+                v += done * 8 * dvdx;
+
+                if (x == end)
+                    break;
+            }
+#endif
+
+            int byteEnd = (x | 7) + 1;
+            if (byteEnd > end)
+                byteEnd = end;
+
+#if SPIRAL_FRONT_TO_BACK
+            uint8_t *covered = coverage + y * STRIDE + (x >> 3);
+            uint8_t skip = *covered;
+
+            if (skip == 0xFF)
+            {
+                RENDER_STAT(occludedPixels, byteEnd - x);
+                u += (byteEnd - x) * dudx;
+                v += (byteEnd - x) * dvdx;
+                x = byteEnd;
+                continue;
+            }
+#else
+            const uint8_t skip = 0;
+#endif
+
+            uint8_t bits = 0, mask = 0;
+
+#if SPIRAL_DITHER_BOUNDS
+            int count = byteEnd - x;
+            bool write, white;
+
+            // Pixels whose result the texture and noise bounds already settle
+            // are stored without fetching a texel.
+            if (shadeRun(shader, x, y, u >> Fixed::FRACTION_BITS, v >> Fixed::FRACTION_BITS,
+                         (u + (count - 1) * dudx) >> Fixed::FRACTION_BITS,
+                         (v + (count - 1) * dvdx) >> Fixed::FRACTION_BITS, write, white))
+            {
+                uint8_t run = runMask(x, byteEnd) & ~skip;
+
+                RENDER_STAT(runPixels, count);
+                mask = write ? run : 0;
+                bits = white ? mask : 0;
+
+                u += count * dudx;
+                v += count * dvdx;
+                x = byteEnd;
+            }
+#endif
+
+            // Whole bytes with nothing to skip go through the packed kernel.
+            if (byteEnd - x == 8 && skip == 0 && shadeByte(shader, x, y, u, v, dudx, dvdx, bits, mask))
+            {
+                for (int i = 0; i < 8; i++)
+                    RENDER_SHADED(x + i, y);
+
+                u += 8 * dudx;
+                v += 8 * dvdx;
+                x = byteEnd;
+            }
+
+            for (; x < byteEnd; x++)
+            {
+                uint16_t color;
+                uint8_t bit = 0x80 >> (x & 7);
+
+                if (skip & bit)
+                {
+                    RENDER_STAT(occludedPixels, 1);
+                }
+                else
+                {
+                    RENDER_SHADED(x, y);
+
+                    if (shader(x, y, u >> Fixed::FRACTION_BITS, v >> Fixed::FRACTION_BITS, color))
+                    {
+                        mask |= bit;
+                        if (color)
+                            bits |= bit;
+                    }
+                }
+
+                u += dudx;
+                v += dvdx;
+            }
+
+            store(row + ((x - 1) >> 3), bits, mask);
+
+#if SPIRAL_FRONT_TO_BACK
+            if (claiming)
+                *covered |= mask;
+#endif
+        }
+    }
+
+    // GxEPD2 keeps its buffer private, so the finished frame goes over in one
+    // pass that only touches the black pixels.
+    void present()
+    {
+        Watchy::display.fillScreen(GxEPD_WHITE);
+        Watchy::display.drawInvertedBitmap(0, 0, bytes, SCREEN_WIDTH, SCREEN_HEIGHT, GxEPD_BLACK);
+    }
+
+    // Bits of pixels [x, end) within one byte.
+    static uint8_t runMask(int x, int end)
+    {
+        return (0xFF >> (x & 7)) & ~(0xFF >> (((end - 1) & 7) + 1));
+    }
+
+    static void store(uint8_t *p, uint8_t bits, uint8_t mask)
+    {
+        if (mask == 0xFF)
+            *p = bits;
+        else
+            *p = (*p & ~mask) | (bits & mask);
+    }
+};
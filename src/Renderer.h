@@ -0,0 +1,23 @@
+#pragma once
+
+#include "RenderConfig.h"
+#include "RenderTarget.h"
+#include "TileRenderer.h"
+#include "ScanlineRenderer.h"
+#include "VisibilityBuffer.h"
+#include "IntensityBuffer.h"
+
+// What drawWatchFace() renders into.
+#if SPIRAL_RENDERER == SPIRAL_RENDERER_TILED
+typedef TileRenderer RenderTarget;
+#elif SPIRAL_RENDERER == SPIRAL_RENDERER_SCANLINE
+typedef ScanlineRenderer RenderTarget;
+#elif SPIRAL_RENDERER == SPIRAL_RENDERER_VISIBILITY
+typedef VisibilityBuffer RenderTarget;
+#elif SPIRAL_RENDERER == SPIRAL_RENDERER_INTENSITY
+typedef IntensityBuffer RenderTarget;
+#elif SPIRAL_DIRECT_FRAMEBUFFER
+typedef FrameBuffer RenderTarget;
+#else
+typedef DisplayTarget RenderTarget;
+#endif
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <Arduino.h>
+#include "RenderConfig.h"
+#include "RenderStats.h"
+#include "Fixed.h"
+#include "Texture.h"
+
+// Texture addressing for whole spans. The rasterizer interpolates texture
+// coordinates at pixel centers, and near the edges of a triangle rounding can
+// carry them a texel past the texture. Checking every texel read would cost
+// the span loops more than the rest of the shading, so Sampler checks each
+// span once instead: a span whose first and last texel lie inside the
+// texture has all of them inside, the mapping being linear, and goes to the
+// render target as it is, to the same unchecked loops as before. Any other
+// span is cut where its coordinates cross an edge of the texture, and the
+// address mode maps each piece back inside:
+//
+// - ClampAddress holds coordinates past an edge on the edge texel, a piece
+//   that does not move along that axis.
+// - WrapAddress moves each piece by whole texture sizes, for repeating
+//   textures.
+// - BorderAddress drops the pieces outside, leaving their pixels as they are.
+//
+// map() works on Q16.16 coordinates without branches; region() gives the
+// coordinates around one that map() treats alike, which is where spans are
+// cut. end is the size of the texture along the axis, in Q16.16.
+//
+// The levels of a mip chain are addressed each on its own, as if it were the
+// whole texture, and only then moved to where the level is in the atlas.
+
+struct ClampAddress
+{
+    static bool map(int32_t& c, int32_t& dc, int32_t end)
+    {
+        int32_t below = c >> 31, above = (end - 1 - c) >> 31;
+
+        c = (c & ~(below | above)) | ((end - Fixed::ONE) & above);
+        dc &= ~(below | above);
+        return true;
+    }
+
+    static void region(int32_t c, int32_t end, int64_t& low, int64_t& high)
+    {
+        low = c < 0 ? INT32_MIN : c < end ? 0 : end;
+        high = c < 0 ? 0 : c < end ? end : INT32_MAX;
+    }
+};
+
+struct WrapAddress
+{
+    static bool map(int32_t& c, int32_t& dc, int32_t end)
+    {
+        // Power of two sizes, known at compile time, only need a mask.
+        c = (end & (end - 1)) == 0 ? c & (end - 1) : c - floorDiv(c, end) * end;
+        return true;
+    }
+
+    static void region(int32_t c, int32_t end, int64_t& low, int64_t& high)
+    {
+        low = (int64_t)floorDiv(c, end) * end;
+        high = low + end;
+    }
+
+    static int32_t floorDiv(int32_t a, int32_t b)
+    {
+        return (a - ((b - 1) & (a >> 31))) / b;
+    }
+};
+
+struct BorderAddress
+{
+    static bool map(int32_t& c, int32_t& dc, int32_t end)
+    {
+        return (c | (end - 1 - c)) >= 0;
+    }
+
+    static void region(int32_t c, int32_t end, int64_t& low, int64_t& high)
+    {
+        ClampAddress::region(c, end, low, high);
+    }
+};
+
+template <typename Texture, typename Address>
+struct Sampler
+{
+    static const int32_t U_END = (int32_t)Texture::WIDTH << Fixed::FRACTION_BITS;
+    static const int32_t V_END = (int32_t)Texture::HEIGHT << Fixed::FRACTION_BITS;
+
+    // Whether all w texels of a span lie inside the texture, or inside a
+    // texture uEnd by vEnd. Negative coordinates compare as huge unsigned
+    // ones.
+    static bool inside(int32_t u, int32_t v, int32_t dudx, int32_t dvdx, int w, int32_t uEnd = U_END,
+                       int32_t vEnd = V_END)
+    {
+        int32_t uLast = u + (w - 1) * dudx, vLast = v + (w - 1) * dvdx;
+
+        return ((uint32_t)u < (uint32_t)uEnd) & ((uint32_t)uLast < (uint32_t)uEnd) &
+               ((uint32_t)v < (uint32_t)vEnd) & ((uint32_t)vLast < (uint32_t)vEnd);
+    }
+
+    template <typename Target, typename Shader>
+    static void shadeSpan(Target& target, int x, int y, int w, int32_t u, int32_t v, int32_t dudx, int32_t dvdx,
+                          const Shader& shader)
+    {
+        shadeRectSpan(target, x, y, w, u, v, dudx, dvdx, U_END, V_END, 0, 0, shader);
+    }
+
+    // A span on one level of a mip chain, its u moved by the level spacing.
+    template <typename Target, typename Shader>
+    static void shadeLevelSpan(const MipChain& mips, Target& target, int x, int y, int w, int32_t u, int32_t v,
+                               int32_t dudx, int32_t dvdx, const Shader& shader)
+    {
+        int level = mips.level(u);
+        int width, height, originU, originV;
+        mips.size(level, width, height);
+        mips.origin(level, originU, originV);
+
+        shadeRectSpan(target, x, y, w, u, v, dudx, dvdx, width << Fixed::FRACTION_BITS,
+                      height << Fixed::FRACTION_BITS, originU << Fixed::FRACTION_BITS,
+                      originV << Fixed::FRACTION_BITS, shader);
+    }
+
+    // Addresses a span within a uEnd by vEnd texture, and moves it by
+    // (uOrigin, vOrigin) to where that texture is.
+    template <typename Target, typename Shader>
+    static void shadeRectSpan(Target& target, int x, int y, int w, int32_t u, int32_t v, int32_t dudx, int32_t dvdx,
+                              int32_t uEnd, int32_t vEnd, int32_t uOrigin, int32_t vOrigin, const Shader& shader)
+    {
+        if (inside(u, v, dudx, dvdx, w, uEnd, vEnd))
+        {
+            target.shadeSpan(x, y, w, u + uOrigin, v + vOrigin, dudx, dvdx, shader);
+            return;
+        }
+
+        RENDER_STAT(addressedSpans, 1);
+
+        for (int end = x + w; x < end;)
+        {
+            int n = run(u, dudx, uEnd, end - x);
+            n = run(v, dvdx, vEnd, n);
+
+            int32_t pieceU = u, pieceV = v, pieceDudx = dudx, pieceDvdx = dvdx;
+            bool visible = Address::map(pieceU, pieceDudx, uEnd);
+
+            if (Address::map(pieceV, pieceDvdx, vEnd) && visible)
+                target.shadeSpan(x, y, n, pieceU + uOrigin, pieceV + vOrigin, pieceDudx, pieceDvdx, shader);
+
+            x += n;
+            u += n * dudx;
+            v += n * dvdx;
+        }
+    }
+
+    // Pixels, at most limit, before a coordinate stepping by dc leaves the
+    // region it starts in.
+    static int run(int32_t c, int32_t dc, int32_t end, int limit)
+    {
+        int64_t low, high, n = limit;
+        Address::region(c, end, low, high);
+
+        if (dc > 0)
+            n = (high - c + dc - 1) / dc;
+        else if (dc < 0)
+            n = (c - low) / -dc + 1;
+
+        return n < limit ? (int)n : limit;
+    }
+};
+
+#if SPIRAL_TEXTURE_ADDRESS == SPIRAL_ADDRESS_WRAP
+typedef WrapAddress TextureAddress;
+#elif SPIRAL_TEXTURE_ADDRESS == SPIRAL_ADDRESS_BORDER
+typedef BorderAddress TextureAddress;
+#else
+typedef ClampAddress TextureAddress;
+#endif
+
+// Hands a span to the target through the sampler of the shader's texture and
+// the address mode of SPIRAL_TEXTURE_ADDRESS, or straight through with
+// SPIRAL_ADDRESS_NONE. Spans on a mip level are moved to the level in the
+// atlas either way.
+template <typename Target, typename Shader>
+void sampleSpan(Target& target, int x, int y, int w, int32_t u, int32_t v, int32_t dudx, int32_t dvdx,
+                const Shader& shader)
+{
+    const MipChain *mips = textureMips(shader.texture);
+
+#if SPIRAL_TEXTURE_ADDRESS == SPIRAL_ADDRESS_NONE
+    if (mips)
+    {
+        int originU, originV;
+        mips->origin(mips->level(u), originU, originV);
+        u += originU << Fixed::FRACTION_BITS;
+        v += originV << Fixed::FRACTION_BITS;
+    }
+
+    target.shadeSpan(x, y, w, u, v, dudx, dvdx, shader);
+#else
+    typedef Sampler<decltype(shader.texture), TextureAddress> TextureSampler;
+
+    if (mips)
+        TextureSampler::shadeLevelSpan(*mips, target, x, y, w, u, v, dudx, dvdx, shader);
+    else
+        TextureSampler::shadeSpan(target, x, y, w, u, v, dudx, dvdx, shader);
+#endif
+}
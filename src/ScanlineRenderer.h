@@ -0,0 +1,359 @@
+#pragma once
+
+#include <Watchy.h>
+#include "RenderConfig.h"
+#include "RenderStats.h"
+#include "Rasterizer.h"
+#include "RenderTarget.h"
+#include "PrimitiveList.h"
+
+// Deferred renderer that draws the recorded frame in a single top to bottom
+// sweep. Primitives are bucketed by their first row (the edge table) and
+// walked with an active list that keeps them in drawing order, so each row is
+// resolved completely before the next one starts. Frame buffer rows and
+// noise mask rows are only ever touched in order, which suits the flash cache
+// and would let rows stream out without keeping the whole frame.
+//
+// The sweep only needs a triangle's vertex positions and texture planes, so
+// triangles are recorded in a packed form, with their shader as an index into
+// a small per-frame table, and lines apart from them. That leaves room for the
+// largest frame the watch face records, 627 triangles and 619 lines.
+struct ScanlineRenderer
+{
+    // A frame that records more than these, uses more shaders or has more
+    // primitives crossing one row is drawn in several sweeps.
+    static const int MAX_TRIANGLES = 704;
+    static const int MAX_LINES = 704;
+    static const int MAX_PRIMITIVES = MAX_TRIANGLES + MAX_LINES;
+    static const int MAX_SHADERS = 16;
+    static const int MAX_ACTIVE = 192;
+
+    // Set in RecordedPrimitive::item for lines.
+    static const uint16_t LINE = 0x8000;
+
+    // Vertex positions are in subpixels and sorted by y. Clipping to the
+    // guard band keeps them well inside 16 bits.
+    struct ScanTriangle
+    {
+        UvGradients gradients;
+        int16_t x[3], y[3];
+        uint8_t shader;
+
+        RasterVertex vertex(int i) const { return {x[i], y[i], 0, 0}; }
+    };
+
+    struct ShaderSlot
+    {
+        SpanFunction shade;
+        const void *shader;
+    };
+
+    // One entry per primitive in drawing order, with the rows it covers.
+    struct RecordedPrimitive
+    {
+        uint16_t item;   // index into triangles, or into lines with LINE set
+        uint8_t y0, y1;
+#if SPIRAL_BENCHMARK && SPIRAL_OVERDRAW
+        uint8_t mesh;
+#endif
+    };
+
+    // A primitive between its first and last row, with the edge walkers
+    // when it is a triangle.
+    struct ActivePrimitive
+    {
+        uint16_t index;
+        bool middleLeft;
+        bool secondHalf;
+        EdgeWalker longEdge, shortEdge;
+    };
+
+    FrameBuffer frame;
+
+    ScanTriangle triangles[MAX_TRIANGLES];
+    RasterLine lines[MAX_LINES];
+    ShaderSlot shaders[MAX_SHADERS];
+    RecordedPrimitive recorded[MAX_PRIMITIVES];
+    int triangleCount = 0, lineCount = 0, shaderCount = 0, recordedCount = 0;
+
+    // Recorded primitives crossing each row, which bounds the active list.
+    uint8_t rowLoad[SCREEN_HEIGHT];
+
+    // Recorded indices sorted by first row, in drawing order within a row.
+    uint16_t rowStart[SCREEN_HEIGHT + 1];
+    uint16_t edgeTable[MAX_PRIMITIVES];
+
+    // Primitives crossing the current row, in drawing order.
+    ActivePrimitive active[MAX_ACTIVE];
+
+    ScanlineRenderer() { clear(); }
+
+    void startWrite() {}
+    void endWrite() {}
+
+    // Clearing the screen makes everything recorded so far invisible.
+    void fill(uint16_t color)
+    {
+        clear();
+        frame.fill(color);
+    }
+
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+        if ((x0 < 0 && x1 < 0) || (y0 < 0 && y1 < 0) ||
+            (x0 >= SCREEN_WIDTH && x1 >= SCREEN_WIDTH) || (y0 >= SCREEN_HEIGHT && y1 >= SCREEN_HEIGHT))
+            return;
+
+        int top = constrain(y0 < y1 ? y0 : y1, 0, SCREEN_HEIGHT - 1);
+        int bottom = constrain(y0 > y1 ? y0 : y1, 0, SCREEN_HEIGHT - 1);
+
+        if (lineCount == MAX_LINES || crowded(top, bottom))
+            flush();
+
+        lines[lineCount].init(x0, y0, x1, y1, color);
+        record(LINE | lineCount++, top, bottom);
+    }
+
+    template <typename Shader>
+    void addTriangle(RasterVertex v0, RasterVertex v1, RasterVertex v2, const Shader& shader)
+    {
+        sortByY(v0, v1, v2);
+
+        UvGradients gradients;
+        if (!gradients.init(v0, v1, v2))
+            return;
+
+        // Same bounds as PrimitiveList::addTriangle(). Sorted, so v0 and v2
+        // bound y.
+        int32_t minX = v0.x < v1.x ? v0.x : v1.x, maxX = v0.x > v1.x ? v0.x : v1.x;
+        minX = v2.x < minX ? v2.x : minX;
+        maxX = v2.x > maxX ? v2.x : maxX;
+
+        int x0 = ceilDiv(minX, SUBPIXEL_ONE), x1 = floorDiv(maxX, SUBPIXEL_ONE);
+        int y0 = ceilDiv(v0.y, SUBPIXEL_ONE), y1 = floorDiv(v2.y, SUBPIXEL_ONE);
+
+        if (x0 > x1 || y0 > y1)
+            return;
+
+        y0 = constrain(y0, 0, SCREEN_HEIGHT - 1);
+        y1 = constrain(y1, 0, SCREEN_HEIGHT - 1);
+
+        SpanFunction shade = &shadeSpanWith<Shader>;
+        int slot = findShader(shade, &shader);
+
+        if (triangleCount == MAX_TRIANGLES || (slot < 0 && shaderCount == MAX_SHADERS) || crowded(y0, y1))
+        {
+            flush();
+            slot = -1;
+        }
+
+        if (slot < 0)
+        {
+            slot = shaderCount++;
+            shaders[slot].shade = shade;
+            shaders[slot].shader = &shader;
+        }
+
+        ScanTriangle &t = triangles[triangleCount];
+        t.gradients = gradients;
+        t.x[0] = v0.x;
+        t.x[1] = v1.x;
+        t.x[2] = v2.x;
+        t.y[0] = v0.y;
+        t.y[1] = v1.y;
+        t.y[2] = v2.y;
+        t.shader = slot;
+        record(triangleCount++, y0, y1);
+    }
+
+    void present()
+    {
+        flush();
+        frame.present();
+    }
+
+    // Draws everything recorded so far, row by row.
+    void flush()
+    {
+        if (recordedCount == 0)
+            return;
+
+        RENDER_STAT(scanlineSweeps, 1);
+
+#if SPIRAL_BENCHMARK && SPIRAL_OVERDRAW
+        uint8_t recordingMesh = renderStats.mesh;
+#endif
+
+        // Counting sort by first row. Filling the buckets back to front keeps
+        // the primitives of each row in drawing order.
+        memset(rowStart, 0, sizeof(rowStart));
+
+        for (int i = 0; i < recordedCount; i++)
+            rowStart[recorded[i].y0]++;
+
+        for (int y = 1; y <= SCREEN_HEIGHT; y++)
+            rowStart[y] += rowStart[y - 1];
+
+        for (int i = recordedCount - 1; i >= 0; i--)
+            edgeTable[--rowStart[recorded[i].y0]] = i;
+
+        int activeCount = 0;
+
+        for (int y = 0; y < SCREEN_HEIGHT; y++)
+        {
+            // Merge the primitives starting on this row into the active list,
+            // both already being in drawing order. Merging from the back
+            // works in place.
+            int first = rowStart[y], next = rowStart[y + 1] - 1;
+            int old = activeCount - 1;
+
+            activeCount += next - first + 1;
+
+            for (int w = activeCount - 1; next >= first; w--)
+            {
+                if (old >= 0 && active[old].index > edgeTable[next])
+                    active[w] = active[old--];
+                else
+                    activate(active[w], edgeTable[next--], y);
+            }
+
+            // Draw the row, dropping primitives that end on it.
+            int kept = 0;
+
+            for (int a = 0; a < activeCount; a++)
+            {
+                ActivePrimitive &t = active[a];
+                const RecordedPrimitive &p = recorded[t.index];
+
+#if SPIRAL_BENCHMARK && SPIRAL_OVERDRAW
+                RENDER_MESH(p.mesh);
+#endif
+
+                if (p.item & LINE)
+                    lines[p.item & ~LINE].draw(frame, 0, y, SCREEN_WIDTH - 1, y);
+                else
+                    drawTriangleRow(t, triangles[p.item], y);
+
+                if (y < p.y1)
+                    active[kept++] = t;
+            }
+
+            activeCount = kept;
+        }
+
+        clear();
+
+#if SPIRAL_BENCHMARK && SPIRAL_OVERDRAW
+        RENDER_MESH(recordingMesh);
+#endif
+    }
+
+private:
+    void clear()
+    {
+        triangleCount = lineCount = shaderCount = recordedCount = 0;
+        memset(rowLoad, 0, sizeof(rowLoad));
+    }
+
+    int findShader(SpanFunction shade, const void *shader) const
+    {
+        for (int i = shaderCount - 1; i >= 0; i--)
+            if (shaders[i].shade == shade && shaders[i].shader == shader)
+                return i;
+
+        return -1;
+    }
+
+    // Whether a primitive on rows y0 to y1 would overflow the active list.
+    bool crowded(int y0, int y1) const
+    {
+        for (int y = y0; y <= y1; y++)
+            if (rowLoad[y] == MAX_ACTIVE)
+                return true;
+
+        return false;
+    }
+
+    void record(uint16_t item, int y0, int y1)
+    {
+        RecordedPrimitive &p = recorded[recordedCount++];
+        p.item = item;
+        p.y0 = y0;
+        p.y1 = y1;
+#if SPIRAL_BENCHMARK && SPIRAL_OVERDRAW
+        p.mesh = renderStats.mesh;
+#endif
+
+        for (int y = y0; y <= y1; y++)
+            rowLoad[y]++;
+    }
+
+    void activate(ActivePrimitive& t, int index, int y)
+    {
+        t.index = index;
+
+        const RecordedPrimitive &p = recorded[index];
+        if (p.item & LINE)
+            return;
+
+        // Same edges as scanTriangle(), started directly on row y.
+        const ScanTriangle &triangle = triangles[p.item];
+        RasterVertex v0 = triangle.vertex(0), v1 = triangle.vertex(1), v2 = triangle.vertex(2);
+        t.middleLeft = triangleArea(v0, v1, v2) < 0;
+        t.longEdge.init(v0, v2, y, SCREEN_HEIGHT);
+        t.secondHalf = y >= ceilDiv(v1.y, SUBPIXEL_ONE);
+
+        if (t.secondHalf)
+            t.shortEdge.init(v1, v2, y, SCREEN_HEIGHT);
+        else
+            t.shortEdge.init(v0, v1, y, SCREEN_HEIGHT);
+    }
+
+    void drawTriangleRow(ActivePrimitive& t, const ScanTriangle& triangle, int y)
+    {
+        if (!t.secondHalf && y >= t.shortEdge.yEnd)
+        {
+            t.shortEdge.init(triangle.vertex(1), triangle.vertex(2), y, SCREEN_HEIGHT);
+            t.secondHalf = true;
+        }
+
+        // Past the bottom vertex, but the bounds still include this row.
+        if (y >= t.shortEdge.yEnd)
+            return;
+
+        EdgeWalker &left = t.middleLeft ? t.shortEdge : t.longEdge;
+        EdgeWalker &right = t.middleLeft ? t.longEdge : t.shortEdge;
+        int x = left.x < 0 ? 0 : left.x;
+        int end = right.x > SCREEN_WIDTH ? SCREEN_WIDTH : right.x;
+
+        if (end > x)
+        {
+            const UvGradients &gradients = triangle.gradients;
+            const ShaderSlot &slot = shaders[triangle.shader];
+            int32_t u, v;
+            gradients.evaluate(x, y, u, v);
+
+            RENDER_STAT(shadedPixels, end - x);
+            RENDER_OVERDRAW(x, y, end - x);
+            slot.shade(frame, x, y, end - x, u, v, gradients.dudx, gradients.dvdx, slot.shader);
+        }
+
+        left.advance();
+        right.advance();
+    }
+};
+
+// Triangles sent to a ScanlineRenderer are recorded instead of scanned. Found
+// by argument dependent lookup from rasterizeTriangle().
+template <typename Shader>
+void scanTriangle(ScanlineRenderer& target, RasterVertex v0, RasterVertex v1, RasterVertex v2, const Shader& shader)
+{
+    target.addTriangle(v0, v1, v2, shader);
+}
+
+// Strip triangles too. Edges are set up when the frame is drawn.
+template <typename Shader>
+void scanStripTriangle(ScanlineRenderer& target, StripEdges& edges, const RasterVertex* v, const Shader& shader)
+{
+    target.addTriangle(v[0], v[1], v[2], shader);
+}
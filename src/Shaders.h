@@ -0,0 +1,327 @@
+#pragma once
+
+#include <Watchy.h>
+#include "RenderConfig.h"
+#include "Texture.h"
+#include "Simd.h"
+#include "Threshold.h"
+#include "../include/Textures.h"
+
+// Pixel shaders are functors called with the pixel position and the integer
+// texel coordinates. They return whether the pixel is written and its color.
+// The rasterizer is a template over the shader type, so every shader/texture
+// combination gets its own inlined span loop.
+//
+// shadeByte() shades a whole frame buffer byte of 8 pixels starting at x, a
+// multiple of 8, from Q16.16 texture coordinates. It returns false for
+// shaders that only work pixel by pixel, otherwise the written pixels in mask
+// and the white ones in bits.
+//
+// shadeBytes() shades count whole bytes of a span from x on, a multiple of
+// 8, into out, with the vector kernels of x86 builds or the ESP32-S3
+// (Simd.h). It returns how many bytes it did, which can be none.
+//
+// shadeRun() can settle up to 8 pixels of one frame buffer byte at once, the
+// texels they read lying between (u0, v0) and (u1, v1). It returns false when
+// the pixels have to be shaded one by one, otherwise whether they are all
+// written and whether they are all white.
+
+// Plain lookup, black or white.
+template <typename Texture>
+struct TextureShader
+{
+    Texture texture;
+
+    bool operator()(int x, int y, int u, int v, uint16_t& color) const
+    {
+        color = texture.texel(u, v) ? GxEPD_WHITE : GxEPD_BLACK;
+        return true;
+    }
+};
+
+// Dithers the texture against the blue noise threshold mask.
+template <typename Texture>
+struct DitherShader
+{
+    Texture texture;
+
+    bool operator()(int x, int y, int u, int v, uint16_t& color) const
+    {
+        color = texture.texel(u, v) > BlueNoise200[y * SCREEN_WIDTH + x] ? GxEPD_WHITE : GxEPD_BLACK;
+        return true;
+    }
+};
+
+// Writes fill wherever the dithered texture comes out dark, or light when
+// Inverted, and leaves all other pixels untouched.
+template <typename Texture, bool Inverted = false>
+struct MaskedColorShader
+{
+    Texture texture;
+    uint16_t fill;
+
+    bool operator()(int x, int y, int u, int v, uint16_t& color) const
+    {
+        bool light = texture.texel(u, v) > BlueNoise200[y * SCREEN_WIDTH + x];
+        color = fill;
+        return light == Inverted;
+    }
+};
+
+// The mip chain of the texture a shader samples, if it has one (Texture.h).
+template <typename Shader>
+const MipChain *mipChain(const Shader& shader)
+{
+    return nullptr;
+}
+
+template <typename Texture>
+const MipChain *mipChain(const DitherShader<Texture>& shader)
+{
+    return textureMips(shader.texture);
+}
+
+template <typename Texture, bool Inverted>
+const MipChain *mipChain(const MaskedColorShader<Texture, Inverted>& shader)
+{
+    return textureMips(shader.texture);
+}
+
+template <typename Shader>
+bool shadeByte(const Shader& shader, int x, int y, int32_t u, int32_t v, int32_t dudx, int32_t dvdx, uint8_t& bits,
+               uint8_t& mask)
+{
+    return false;
+}
+
+#if SPIRAL_KERNEL != SPIRAL_KERNEL_SCALAR
+// Gathers the 8 texels into two words and compares them with the 8 noise
+// values of the byte four at a time (Threshold.h). Whether a pixel comes out
+// light is decided exactly as DitherShader decides it.
+template <typename Texture>
+uint8_t ditherByte(const Texture& texture, int x, int y, int32_t u, int32_t v, int32_t dudx, int32_t dvdx)
+{
+    uint32_t texels[2], noise[2];
+
+    for (int w = 0; w < 2; w++)
+    {
+        uint32_t word = 0;
+
+        for (int k = 0; k < 32; k += 8)
+        {
+            word |= (uint32_t)texture.texel(u >> Fixed::FRACTION_BITS, v >> Fixed::FRACTION_BITS) << k;
+            u += dudx;
+            v += dvdx;
+        }
+
+        texels[w] = word;
+    }
+
+    memcpy(noise, BlueNoise200 + y * SCREEN_WIDTH + x, 8);
+    return thresholdWords(texels[0], texels[1], noise[0], noise[1]);
+}
+
+template <typename Texture>
+bool shadeByte(const DitherShader<Texture>& shader, int x, int y, int32_t u, int32_t v, int32_t dudx, int32_t dvdx,
+               uint8_t& bits, uint8_t& mask)
+{
+    bits = ditherByte(shader.texture, x, y, u, v, dudx, dvdx);
+    mask = 0xFF;
+    return true;
+}
+
+template <typename Texture, bool Inverted>
+bool shadeByte(const MaskedColorShader<Texture, Inverted>& shader, int x, int y, int32_t u, int32_t v, int32_t dudx,
+               int32_t dvdx, uint8_t& bits, uint8_t& mask)
+{
+    uint8_t light = ditherByte(shader.texture, x, y, u, v, dudx, dvdx);
+    mask = Inverted ? light : ~light;
+    bits = shader.fill != GxEPD_BLACK ? mask : 0;
+    return true;
+}
+#endif
+
+template <typename Shader>
+int shadeBytes(const Shader& shader, int x, int y, int32_t u, int32_t v, int32_t dudx, int32_t dvdx, uint8_t *out,
+               int count)
+{
+    return 0;
+}
+
+#if SPIRAL_X86_SIMD
+// 16 pixels per iteration: the texels are gathered one by one, then compared
+// with the noise all at once. Signed compares after flipping the high bits
+// are unsigned compares.
+template <int W>
+SIMD_TARGET_SSE2 int ditherBytesSse2(const uint8_t *pixels, int x, int y, int32_t u, int32_t v, int32_t dudx,
+                                     int32_t dvdx, uint8_t *out, int count)
+{
+    const __m128i bias = _mm_set1_epi8((char)0x80);
+    const uint8_t *noise = BlueNoise200 + y * SCREEN_WIDTH + x;
+    int i = 0;
+
+    for (; i + 2 <= count; i += 2)
+    {
+        uint8_t texels[16];
+
+        for (int k = 0; k < 16; k++)
+        {
+            texels[k] = pixels[(v >> Fixed::FRACTION_BITS) * W + (u >> Fixed::FRACTION_BITS)];
+            u += dudx;
+            v += dvdx;
+        }
+
+        __m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i *)texels), bias);
+        __m128i n = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(noise + i * 8)), bias);
+        uint32_t m = reverseBitsInBytes(_mm_movemask_epi8(_mm_cmpgt_epi8(a, n)));
+
+        out[i] = m;
+        out[i + 1] = m >> 8;
+    }
+
+    return i;
+}
+
+// 32 pixels per iteration, with the texel addresses computed 8 at a time.
+// What is left over goes through the SSE2 kernel.
+template <int W>
+SIMD_TARGET_AVX2 int ditherBytesAvx2(const uint8_t *pixels, int x, int y, int32_t u, int32_t v, int32_t dudx,
+                                     int32_t dvdx, uint8_t *out, int count)
+{
+    const __m256i bias = _mm256_set1_epi8((char)0x80);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i width = _mm256_set1_epi32(W);
+    const __m256i stepU = _mm256_set1_epi32(dudx * 8), stepV = _mm256_set1_epi32(dvdx * 8);
+    const uint8_t *noise = BlueNoise200 + y * SCREEN_WIDTH + x;
+
+    __m256i us = _mm256_add_epi32(_mm256_set1_epi32(u), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dudx)));
+    __m256i vs = _mm256_add_epi32(_mm256_set1_epi32(v), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dvdx)));
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        alignas(32) int32_t index[32];
+        alignas(32) uint8_t texels[32];
+
+        for (int g = 0; g < 32; g += 8)
+        {
+            __m256i row = _mm256_mullo_epi32(_mm256_srai_epi32(vs, Fixed::FRACTION_BITS), width);
+            __m256i texel = _mm256_add_epi32(row, _mm256_srai_epi32(us, Fixed::FRACTION_BITS));
+            _mm256_store_si256((__m256i *)(index + g), texel);
+
+            us = _mm256_add_epi32(us, stepU);
+            vs = _mm256_add_epi32(vs, stepV);
+        }
+
+        for (int k = 0; k < 32; k++)
+            texels[k] = pixels[index[k]];
+
+        __m256i a = _mm256_xor_si256(_mm256_load_si256((const __m256i *)texels), bias);
+        __m256i n = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(noise + i * 8)), bias);
+        uint32_t m = reverseBitsInBytes(_mm256_movemask_epi8(_mm256_cmpgt_epi8(a, n)));
+
+        for (int k = 0; k < 4; k++)
+            out[i + k] = m >> (k * 8);
+    }
+
+    return i + ditherBytesSse2<W>(pixels, x + i * 8, y, u + i * 8 * dudx, v + i * 8 * dvdx, dudx, dvdx,
+                                    out + i, count - i);
+}
+#endif
+
+#if SPIRAL_KERNEL == SPIRAL_KERNEL_PIE
+// 16 pixels per iteration: the texels are gathered one by one into a vector
+// and compared with the noise in one go.
+template <typename Texture>
+int ditherBytesPie(const Texture& texture, int x, int y, int32_t u, int32_t v, int32_t dudx, int32_t dvdx,
+                   uint8_t *out, int count)
+{
+    alignas(16) uint8_t texels[16];
+    alignas(16) uint8_t above[16];
+    const uint8_t *noise = BlueNoise200 + y * SCREEN_WIDTH + x;
+    int i = 0;
+
+    for (; i + 2 <= count; i += 2)
+    {
+        for (int k = 0; k < 16; k++)
+        {
+            texels[k] = texture.texel(u >> Fixed::FRACTION_BITS, v >> Fixed::FRACTION_BITS);
+            u += dudx;
+            v += dvdx;
+        }
+
+        bytesAbove16(texels, noise + i * 8, above);
+        out[i] = packAboveBytes(above);
+        out[i + 1] = packAboveBytes(above + 8);
+    }
+
+    return i;
+}
+#endif
+
+template <int W, int H, int Layout>
+int shadeBytes(const DitherShader<GrayTexture<W, H, Layout> >& shader, int x, int y, int32_t u, int32_t v,
+               int32_t dudx, int32_t dvdx, uint8_t *out, int count)
+{
+#if SPIRAL_KERNEL == SPIRAL_KERNEL_PIE
+    return ditherBytesPie(shader.texture, x, y, u, v, dudx, dvdx, out, count);
+#else
+#if SPIRAL_X86_SIMD
+    // The gathers compute row major texel addresses.
+    if (Layout == SPIRAL_LAYOUT_ROWS)
+        switch (simdLevel())
+        {
+        case SPIRAL_SIMD_AVX2:
+            return ditherBytesAvx2<W>(shader.texture.pixels, x, y, u, v, dudx, dvdx, out, count);
+        case SPIRAL_SIMD_SSE2:
+            return ditherBytesSse2<W>(shader.texture.pixels, x, y, u, v, dudx, dvdx, out, count);
+        }
+#endif
+
+    return 0;
+#endif
+}
+
+template <typename Shader>
+bool shadeRun(const Shader& shader, int x, int y, int u0, int v0, int u1, int v1, bool& write, bool& white)
+{
+    return false;
+}
+
+// The texels are all above the noise of the byte, or none of them are.
+// Returns +1 for all light, -1 for all dark and 0 when it is not settled.
+// The first texel already rules out most bytes, before the pyramid is read.
+template <int W, int H, int Layout>
+int ditherRun(const GrayTexture<W, H, Layout>& texture, int x, int y, int u0, int v0, int u1, int v1)
+{
+    const uint8_t *noise = BlueNoise200MinMax + (y * (SCREEN_WIDTH / 8) + (x >> 3)) * 2;
+    uint8_t noiseLow = pgm_read_byte(noise), noiseHigh = pgm_read_byte(noise + 1);
+    uint8_t first = texture.texel(u0, v0), low, high;
+
+    if (first > noiseHigh)
+        return texture.range(u0, v0, u1, v1, low, high) && low > noiseHigh ? 1 : 0;
+    if (first <= noiseLow)
+        return texture.range(u0, v0, u1, v1, low, high) && high <= noiseLow ? -1 : 0;
+
+    return 0;
+}
+
+template <int W, int H, int Layout>
+bool shadeRun(const DitherShader<GrayTexture<W, H, Layout> >& shader, int x, int y, int u0, int v0, int u1, int v1,
+              bool& write, bool& white)
+{
+    int run = ditherRun(shader.texture, x, y, u0, v0, u1, v1);
+    write = true;
+    white = run > 0;
+    return run != 0;
+}
+
+template <int W, int H, int Layout, bool Inverted>
+bool shadeRun(const MaskedColorShader<GrayTexture<W, H, Layout>, Inverted>& shader, int x, int y, int u0, int v0, int u1,
+              int v1, bool& write, bool& white)
+{
+    int run = ditherRun(shader.texture, x, y, u0, v0, u1, v1);
+    write = (run > 0) == Inverted;
+    white = shader.fill != GxEPD_BLACK;
+    return run != 0;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "RenderConfig.h"
+
+// Vector kernels for x86 builds, the previews and regression images rendered
+// on a desktop. The SSE2 and AVX2 variants are compiled into every x86 build
+// with per-function target attributes and chosen at run time from what the
+// CPU supports, up to SPIRAL_SIMD. Other builds only have the portable
+// kernels, which every variant matches bit for bit.
+#if (defined(__x86_64__) || defined(__i386__)) && SPIRAL_SIMD > SPIRAL_SIMD_NONE && \
+    SPIRAL_KERNEL == SPIRAL_KERNEL_SWAR && !(SPIRAL_BENCHMARK && SPIRAL_CACHE_MODEL)
+#define SPIRAL_X86_SIMD 1
+#include <immintrin.h>
+
+#define SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+
+inline int supportedSimdLevel()
+{
+    __builtin_cpu_init();
+
+    if (SPIRAL_SIMD >= SPIRAL_SIMD_AVX2 && __builtin_cpu_supports("avx2"))
+        return SPIRAL_SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SPIRAL_SIMD_SSE2;
+
+    return SPIRAL_SIMD_NONE;
+}
+
+inline int& activeSimdLevel()
+{
+    static int level = supportedSimdLevel();
+    return level;
+}
+
+inline int simdLevel()
+{
+    return activeSimdLevel();
+}
+
+// Lets the benchmark compare the levels. Levels the CPU lacks are clamped.
+inline void setSimdLevel(int level)
+{
+    int supported = supportedSimdLevel();
+    activeSimdLevel() = level < supported ? level : supported;
+}
+#else
+#define SPIRAL_X86_SIMD 0
+
+inline int supportedSimdLevel() { return SPIRAL_SIMD_NONE; }
+inline int simdLevel() { return SPIRAL_SIMD_NONE; }
+inline void setSimdLevel(int level) {}
+#endif
+
+// movemask puts the first pixel in bit 0 of each byte, the frame buffer wants
+// it in bit 7.
+inline uint32_t reverseBitsInBytes(uint32_t m)
+{
+    m = ((m & 0xF0F0F0F0) >> 4) | ((m & 0x0F0F0F0F) << 4);
+    m = ((m & 0xCCCCCCCC) >> 2) | ((m & 0x33333333) << 2);
+    return ((m & 0xAAAAAAAA) >> 1) | ((m & 0x55555555) << 1);
+}
+
+#if SPIRAL_KERNEL == SPIRAL_KERNEL_PIE
+// Sets each of the 16 bytes of above to 0xFF where a is above b, unsigned,
+// and to 0 elsewhere. above has to be 16 byte aligned, a and b need not be.
+//
+// On the ESP32-S3 this is a handful of PIE instructions. Unaligned vectors
+// are put together from the two aligned ones around them; the second one is
+// loaded through the address of the last byte, so nothing past that byte's
+// own 16 byte block is read. The compares are signed, so the high bits are
+// flipped first. Other builds run the same lanes as plain C.
+inline void bytesAbove16(const uint8_t *a, const uint8_t *b, uint8_t *above)
+{
+#ifdef __XTENSA__
+    static const uint8_t bias = 0x80;
+
+    asm volatile("ee.vldbc.8 q4, %[bias]\n"
+                 "ee.ld.128.usar.ip q0, %[a], 0\n"
+                 "ee.vld.128.ip q1, %[aLast], 0\n"
+                 "ee.src.q q0, q0, q1\n"
+                 "ee.ld.128.usar.ip q2, %[b], 0\n"
+                 "ee.vld.128.ip q3, %[bLast], 0\n"
+                 "ee.src.q q2, q2, q3\n"
+                 "ee.xorq q0, q0, q4\n"
+                 "ee.xorq q2, q2, q4\n"
+                 "ee.vcmp.gt.s8 q0, q0, q2\n"
+                 "ee.vst.128.ip q0, %[above], 0\n"
+                 :
+                 : [a] "r"(a), [aLast] "r"(a + 15), [b] "r"(b), [bLast] "r"(b + 15), [above] "r"(above),
+                   [bias] "r"(&bias)
+                 : "memory");
+#else
+    for (int k = 0; k < 16; k++)
+        above[k] = a[k] > b[k] ? 0xFF : 0;
+#endif
+}
+#endif
@@ -1,5 +1,9 @@
 #include "SpiralWatchy.h"
 
+#if SPIRAL_BENCHMARK
+RenderStats renderStats;
+#endif
+
 const float VOLTAGE_MIN = 3.5;
 const float VOLTAGE_MAX = 4.2;
 const float VOLTAGE_WARNING = 3.6;
@@ -7,7 +11,7 @@ const float VOLTAGE_RANGE = VOLTAGE_MAX - VOLTAGE_MIN;
 
 const int DENSITY = 1;
 const int VECTOR_SIZE = 60 * DENSITY;
-const double STEP_ANGLE = 360 / VECTOR_SIZE;
+const Real STEP_ANGLE = 360 / VECTOR_SIZE;
 
 const int STEP_MINUTE = DENSITY;
 const int STEP_HOUR = VECTOR_SIZE/12;
@@ -17,12 +21,12 @@ const int RADIUS = 99;
 const int RIM_SIZE = 20;
 const int FACE_RADIUS = 260 - RIM_SIZE;
 
-const double BATTERY_MIN = 0.5;
-const double BATTERY_RANGE = 1.0 - BATTERY_MIN;
-const double BATTERY_WARNING = BATTERY_MIN + ((VOLTAGE_WARNING - VOLTAGE_MIN) / VOLTAGE_RANGE) * BATTERY_RANGE;
+const Real BATTERY_MIN = 0.5;
+const Real BATTERY_RANGE = 1.0 - BATTERY_MIN;
+const Real BATTERY_WARNING = BATTERY_MIN + ((VOLTAGE_WARNING - VOLTAGE_MIN) / VOLTAGE_RANGE) * BATTERY_RANGE;
 
 
-const double LOOP_SCALE = 0.45;
+const Real LOOP_SCALE = 0.45;
 
 const Vector HAND[] =
 {{0, -1.0},
@@ -64,6 +68,64 @@ const int HAND_OUTLINE_INDEX[] = {0,2,4,5,6};
 
 const int HAND_OUTLINE_LEN = 5;
 
+// Groups of triangles that tile without overlapping, for the overdraw count.
+enum Mesh
+{
+  MESH_NONE,
+  MESH_FACE,
+  MESH_RIM,
+  MESH_CENTER,
+  MESH_HOUR_HAND,
+  MESH_MINUTE_HAND
+};
+
+// The min/max pyramids are only read with SPIRAL_DITHER_BOUNDS. Without it
+// nothing refers to them and the linker leaves them out of flash.
+#if SPIRAL_DITHER_BOUNDS
+#define DITHER_BOUNDS(pyramid) pyramid
+#else
+#define DITHER_BOUNDS(pyramid) NO_TEXTURE
+#endif
+
+#if SPIRAL_TEXTURE_FORMAT == SPIRAL_TEXTURE_PALETTE4
+typedef PaletteTexture200 FaceTexture;
+typedef PaletteTexture200 RimTexture;
+
+const DitherShader<FaceTexture> FACE_SHADER = {{SpiralFaceWithShadowPalette4}};
+const DitherShader<RimTexture> MATCAP_SHADER = {{MatCapSourcePalette4}};
+const MaskedColorShader<PaletteTexture200> CENTER_SHADOW_SHADER = {{SpiralFaceShadowCenterPalette4}, GxEPD_BLACK};
+#elif SPIRAL_MIPMAPS
+// The face and the rim shrink towards the center, the center shadow does not.
+typedef GrayTexture<300, 200> FaceTexture;
+typedef GrayTexture<300, 200> RimTexture;
+
+const MipChain MIPS_200 = {200, 200, 7};
+const DitherShader<FaceTexture> FACE_SHADER = {
+    {SpiralFaceWithShadowMips, DITHER_BOUNDS(SpiralFaceWithShadowMipsMinMax), &MIPS_200}};
+const DitherShader<RimTexture> MATCAP_SHADER = {{MatCapSourceMips, DITHER_BOUNDS(MatCapSourceMipsMinMax), &MIPS_200}};
+const MaskedColorShader<Texture200> CENTER_SHADOW_SHADER = {
+    {SpiralFaceShadowCenter, DITHER_BOUNDS(SpiralFaceShadowCenterMinMax)}, GxEPD_BLACK};
+#else
+// Only the face, which covers most of the screen, comes in other layouts.
+typedef GrayTexture<200, 200, SPIRAL_TEXTURE_LAYOUT> FaceTexture;
+typedef Texture200 RimTexture;
+
+#if SPIRAL_TEXTURE_LAYOUT == SPIRAL_LAYOUT_PADDED
+const DitherShader<FaceTexture> FACE_SHADER = {{SpiralFaceWithShadowPadded, DITHER_BOUNDS(SpiralFaceWithShadowMinMax)}};
+#elif SPIRAL_TEXTURE_LAYOUT == SPIRAL_LAYOUT_TILED4
+const DitherShader<FaceTexture> FACE_SHADER = {{SpiralFaceWithShadowTiled4, DITHER_BOUNDS(SpiralFaceWithShadowMinMax)}};
+#elif SPIRAL_TEXTURE_LAYOUT == SPIRAL_LAYOUT_TILED8
+const DitherShader<FaceTexture> FACE_SHADER = {{SpiralFaceWithShadowTiled8, DITHER_BOUNDS(SpiralFaceWithShadowMinMax)}};
+#elif SPIRAL_TEXTURE_LAYOUT == SPIRAL_LAYOUT_MORTON
+const DitherShader<FaceTexture> FACE_SHADER = {{SpiralFaceWithShadowMorton, DITHER_BOUNDS(SpiralFaceWithShadowMinMax)}};
+#else
+const DitherShader<FaceTexture> FACE_SHADER = {{SpiralFaceWithShadow, DITHER_BOUNDS(SpiralFaceWithShadowMinMax)}};
+#endif
+const DitherShader<RimTexture> MATCAP_SHADER = {{MatCapSource, DITHER_BOUNDS(MatCapSourceMinMax)}};
+const MaskedColorShader<Texture200> CENTER_SHADOW_SHADER = {
+    {SpiralFaceShadowCenter, DITHER_BOUNDS(SpiralFaceShadowCenterMinMax)}, GxEPD_BLACK};
+#endif
+
 Vector EDGE_VECTORS[VECTOR_SIZE];
 Vector EDGE_NORMAL[VECTOR_SIZE];
 
@@ -79,16 +141,99 @@ SpiralWatchy::SpiralWatchy(const watchySettings& s) : Watchy(s)
   }
 }
 
-static double lerp(double a, double b, double f)
+#if SPIRAL_BANDS == SPIRAL_BANDS_POLYGONS
+// Point i of the spiral's outer edge, moved out by rimSize at full scale.
+// Evaluated exactly like the triangle vertices, so both paths cover the same
+// pixels.
+static Vector spiralPoint(int i, Real minuteNormalized, Real rimSize)
 {
-    return a * (1.0 - f) + (b * f);
+  Real loopScale = scalarPow(LOOP_SCALE, Real(i) / Real(VECTOR_SIZE) - minuteNormalized);
+  Real scale = FACE_RADIUS * loopScale;
+  return EDGE_VECTORS[i % VECTOR_SIZE] * (scale + rimSize * loopScale) + CENTER;
 }
 
+// Texture coordinates of the polygon bands, in float whatever the precision.
+// The triangles interpolate the texture between the vertices on the two
+// edges of a band, which is linear in the distance from the center; this
+// finds where between the edges a pixel lies and evaluates the same mapping
+// at both ends of a span.
+struct SpiralBandMapping
+{
+  float minuteNormalized;
+  float rimScale;   // rim width over FACE_RADIUS, 0 for the face
+
+  void operator()(int x, int y, int w, int32_t& u, int32_t& v, int32_t& dudx, int32_t& dvdx) const
+  {
+    // Spans never cross an edge of the band, so the middle pixel tells which
+    // turn of the spiral the whole span lies in. Going by each end pixel
+    // instead would put pixels just beyond the curved edge, but inside its
+    // straight chord, into the next turn.
+    float turn = turns(x + (w - 1) * 0.5f, y);
+    turn = rimScale == 0 ? floorf(turn) : ceilf(turn);
+
+    evaluate(x, y, turn, u, v);
+    dudx = dvdx = 0;
+
+    if (w > 1)
+    {
+      int32_t uEnd, vEnd;
+      evaluate(x + w - 1, y, turn, uEnd, vEnd);
+      dudx = (uEnd - u) / (w - 1);
+      dvdx = (vEnd - v) / (w - 1);
+    }
+  }
+
+  // Turns of the spiral from the outer edge point at the pixel's angle in to
+  // the pixel. Edge point i points along EDGE_VECTORS[i], i steps from -x.
+  float turns(float x, int y) const
+  {
+    float dx = x + 0.5f - (float)CENTER.x, dy = y + 0.5f - (float)CENTER.y;
+    float angle = (atan2f(dy, dx) * float(RAD_TO_DEG) + 180.0f) / 360.0f;
+    float r = sqrtf(dx * dx + dy * dy);
+
+    return logf(r / FACE_RADIUS) / logf((float)LOOP_SCALE) + minuteNormalized - angle;
+  }
+
+  void evaluate(int x, int y, float turn, int32_t& u, int32_t& v) const
+  {
+    float dx = x + 0.5f - (float)CENTER.x, dy = y + 0.5f - (float)CENTER.y;
+    float r = sqrtf(dx * dx + dy * dy);
+    float offset = turns(x, y) - turn;
+    float scale;
+
+    if (rimScale == 0)
+    {
+      // From the outer edge at offset 0 to the inner edge at 1.
+      scale = RADIUS * powf((float)LOOP_SCALE, constrain(offset, 0.0f, 1.0f)) / r;
+    }
+    else
+    {
+      // From the face edge at -1 to the outer rim edge at 1.
+      float w = (powf((float)LOOP_SCALE, offset) - 1.0f) / rimScale;
+      scale = RADIUS * (2.0f * constrain(w, 0.0f, 1.0f) - 1.0f) / r;
+    }
+
+    u = toFixedRaw((float)CENTER.x + dx * scale);
+    v = toFixedRaw((float)CENTER.y + dy * scale);
+  }
+};
+#endif
+
 void SpiralWatchy::drawWatchFace()
 {
-  display.fillScreen(GxEPD_WHITE);
+  target.fill(GxEPD_WHITE);
   display.setTextColor(GxEPD_BLACK);
 
+#if SPIRAL_TEXTURE_PARTITION
+  // The packed textures are null until mapTextures() has succeeded; setup()
+  // has reported why it did not.
+  if (mapTextures())
+  {
+    target.present();
+    return;
+  }
+#endif
+
   Vector normals[VECTOR_SIZE];
 
   for (int i = 0; i < VECTOR_SIZE; i++)
@@ -99,97 +244,164 @@ void SpiralWatchy::drawWatchFace()
   int hour = currentTime.Hour;
   int minute = currentTime.Minute;
   
-  double minuteNormalized = minute / 60.0;
-  double hourNormalized = (hour + minuteNormalized) / 24.0;
+  Real minuteNormalized = Real(minute) / Real(60);
+
+  Real batteryFill = getBatteryFill();
+  Real batteryFillScale = BATTERY_MIN + BATTERY_RANGE * batteryFill;
+  Real rimSize = RIM_SIZE * batteryFillScale;
+
+#if SPIRAL_FRONT_TO_BACK
+  // The hands and the center square claim their pixels first, and the spiral
+  // behind them only shades what is left.
+  target.claiming = true;
+  drawForeground(hour, minute, minuteNormalized);
+  target.claiming = false;
+#endif
+
+
+#if SPIRAL_BANDS == SPIRAL_BANDS_POLYGONS
+  // Each band is one polygon, out along one edge of the spiral and back along
+  // the other. The edges between the turns of the face are run through twice,
+  // in opposite directions, and cancel.
+  RENDER_MESH(MESH_FACE);
 
-  double batteryFill = getBatteryFill();
-  double batteryFillScale = BATTERY_MIN + BATTERY_RANGE * batteryFill;
-  double rimSize = RIM_SIZE * batteryFillScale;
+  for (int i = minute; i <= VECTOR_SIZE * 3 + minute; i++)
+    polygon.addPoint(spiralPoint(i, minuteNormalized, 0));
+  for (int i = VECTOR_SIZE * 4 + minute; i >= VECTOR_SIZE + minute; i--)
+    polygon.addPoint(spiralPoint(i, minuteNormalized, 0));
 
+  polygon.closeContour();
+  polygon.fill(target, SpiralBandMapping{(float)minuteNormalized, 0}, FACE_SHADER);
+
+  RENDER_MESH(MESH_RIM);
+
+  for (int i = minute; i <= VECTOR_SIZE * 3 + minute; i++)
+    polygon.addPoint(spiralPoint(i, minuteNormalized, rimSize));
+  for (int i = VECTOR_SIZE * 3 + minute; i >= minute; i--)
+    polygon.addPoint(spiralPoint(i, minuteNormalized, 0));
+
+  polygon.closeContour();
+  polygon.fill(target, SpiralBandMapping{(float)minuteNormalized, (float)(rimSize / FACE_RADIUS)}, MATCAP_SHADER);
 
   for (int i = minute; i < VECTOR_SIZE * 3 + minute; i++)
+  {
+    drawLine(spiralPoint(i, minuteNormalized, 0), spiralPoint(i + 1, minuteNormalized, 0), GxEPD_BLACK);
+    drawLine(spiralPoint(i, minuteNormalized, rimSize), spiralPoint(i + 1, minuteNormalized, rimSize), GxEPD_BLACK);
+  }
+#else
+  // The face and the rim are triangle strips zigzagging between two edges of
+  // the spiral. Each segment adds one vertex per edge to both strips, which
+  // fills the quad between this step and the last one, then outlines it.
+  TriangleStrip<RenderTarget, DitherShader<FaceTexture> > face(target, FACE_SHADER);
+  TriangleStrip<RenderTarget, DitherShader<RimTexture> > rim(target, MATCAP_SHADER);
+  Vector lastV1 = CENTER, lastV4 = CENTER;
+
+  for (int i = minute; i <= VECTOR_SIZE * 3 + minute; i++)
   {
     int index = i % VECTOR_SIZE;
-    int nextIndex = (i + 1) % VECTOR_SIZE;
 
-    double loopScale1 = pow(LOOP_SCALE, i / (float)VECTOR_SIZE - minuteNormalized);
-    double scale1 = FACE_RADIUS * loopScale1;
+    Real loopScale1 = scalarPow(LOOP_SCALE, Real(i) / Real(VECTOR_SIZE) - minuteNormalized);
+    Real scale1 = FACE_RADIUS * loopScale1;
     Vector v1 = EDGE_VECTORS[index] * scale1 + CENTER;
     Vector uv1 = normals[index] * RADIUS + CENTER;
 
-    double loopScale2 = pow(LOOP_SCALE, (i + 1) / (float)VECTOR_SIZE - minuteNormalized);
-    double scale2 = FACE_RADIUS * loopScale2;
-    Vector v2 = EDGE_VECTORS[nextIndex] * scale2 + CENTER;
-    Vector uv2 = normals[nextIndex] * RADIUS + CENTER;
-
-    double scale3 = scale1 * LOOP_SCALE;
+    // The inner edge is computed exactly like v1 of the loop inside this one,
+    // so neighbouring turns share their vertices bit for bit.
+    Real scale3 = FACE_RADIUS * scalarPow(LOOP_SCALE, Real(i + VECTOR_SIZE) / Real(VECTOR_SIZE) - minuteNormalized);
     Vector v1a = EDGE_VECTORS[index] * scale3 + CENTER;
     Vector uv1a = normals[index] * RADIUS * LOOP_SCALE + CENTER;
 
-    double scale4 = scale2 * LOOP_SCALE;
-    Vector v2a = EDGE_VECTORS[nextIndex] * scale4 + CENTER;
-    Vector uv2a = normals[nextIndex] * RADIUS * LOOP_SCALE + CENTER;
-
-    fillTriangle2(v1a, uv1a, v1, uv1, v2, uv2, SpiralFaceWithShadow, 200, 200);
-    fillTriangle2(v2a, uv2a, v1a, uv1a, v2, uv2, SpiralFaceWithShadow, 200, 200);
-    //fillTriangle(v1a, uv1a, v1, uv1, v2, uv2, SpiralFaceShadow, 200, 200, GxEPD_BLACK);
-    //fillTriangle(v2a, uv2a, v1a, uv1a, v2, uv2, SpiralFaceShadow, 200, 200, GxEPD_BLACK);
+    RENDER_MESH(MESH_FACE);
+    face.add(v1, uv1);
+    face.add(v1a, uv1a);
 
     Vector v4 = EDGE_VECTORS[index] * (scale1 + rimSize * loopScale1) + CENTER;
     Vector uv3 = normals[index] * -RADIUS + CENTER;
     Vector uv4 = normals[index] * RADIUS + CENTER;
 
-    Vector v6 = EDGE_VECTORS[nextIndex] * (scale2 + rimSize * loopScale2) + CENTER;
-    Vector uv5 = normals[nextIndex] * -RADIUS + CENTER;
-    Vector uv6 = normals[nextIndex] * RADIUS + CENTER;
+    RENDER_MESH(MESH_RIM);
+    rim.add(v1, uv3);
+    rim.add(v4, uv4);
 
-    fillTriangle2(v1, uv3, v4, uv4, v2, uv5, MatCapSource, 200, 200);
-    fillTriangle2(v4, uv4, v2, uv5, v6, uv6, MatCapSource, 200, 200);
+    if (i > minute)
+    {
+      drawLine(lastV1, v1, GxEPD_BLACK);
+      drawLine(lastV4, v4, GxEPD_BLACK);
+    }
 
-    display.drawLine(v1.x, v1.y, v2.x, v2.y, GxEPD_BLACK);
-    display.drawLine(v4.x, v4.y, v6.x, v6.y, GxEPD_BLACK);
+    lastV1 = v1;
+    lastV4 = v4;
   }
+#endif
 
   for (int i = VECTOR_SIZE * 3 + minute; i < VECTOR_SIZE * 4 + minute; i++)
   {
     int index = i % VECTOR_SIZE;
     int nextIndex = (i + 1) % VECTOR_SIZE;
 
-    double loopScale1 = pow(LOOP_SCALE, i / (float)VECTOR_SIZE - minuteNormalized);
-    double scale1 = FACE_RADIUS * loopScale1;
+    Real loopScale1 = scalarPow(LOOP_SCALE, Real(i) / Real(VECTOR_SIZE) - minuteNormalized);
+    Real scale1 = FACE_RADIUS * loopScale1;
     Vector v1 = EDGE_VECTORS[index] * scale1 + CENTER;
 
-    double loopScale2 = pow(LOOP_SCALE, (i + 1) / (float)VECTOR_SIZE - minuteNormalized);
-    double scale2 = FACE_RADIUS * loopScale2;
+    Real loopScale2 = scalarPow(LOOP_SCALE, Real(i + 1) / Real(VECTOR_SIZE) - minuteNormalized);
+    Real scale2 = FACE_RADIUS * loopScale2;
     Vector v2 = EDGE_VECTORS[nextIndex] * scale2 + CENTER;
 
     Vector v4 = EDGE_VECTORS[index] * (scale1 + rimSize * loopScale1) + CENTER;
 
     Vector v6 = EDGE_VECTORS[nextIndex] * (scale2 + rimSize * loopScale2) + CENTER;
 
-    display.drawTriangle(v1.x, v1.y, v4.x, v4.y, v2.x, v2.y, GxEPD_BLACK);
-    display.drawTriangle(v4.x, v4.y, v2.x, v2.y, v6.x, v6.y, GxEPD_BLACK);
+    drawTriangle(v1, v4, v2, GxEPD_BLACK);
+    drawTriangle(v4, v2, v6, GxEPD_BLACK);
   }
 
+#if !SPIRAL_FRONT_TO_BACK
+  drawForeground(hour, minute, minuteNormalized);
+#endif
+
+  target.present();
+}
+
+// The center square and the hands in front of the spiral, back to front, or
+// front to back when the frame is drawn that way.
+void SpiralWatchy::drawForeground(int hour, int minute, Real minuteNormalized)
+{
   Vector corner1 = {50.0,50.0};
   Vector corner2 = {149.0,50.0};
   Vector corner3 = {149.0,149.0};
   Vector corner4 = {50.0,149.0};
 
-  fillTriangle(corner1, corner1, corner2, corner2, corner3, corner3, SpiralFaceShadowCenter, 200, 200, GxEPD_BLACK);
-  fillTriangle(corner3, corner3, corner4, corner4, corner1, corner1, SpiralFaceShadowCenter, 200, 200, GxEPD_BLACK);
+  Real hourAngle = (Real(hour % 12) + minuteNormalized) * Real(30);
+
+#if SPIRAL_FRONT_TO_BACK
+  RENDER_MESH(MESH_MINUTE_HAND);
+  DrawHand(Real(minute * 6), Real(90));
+  RENDER_MESH(MESH_HOUR_HAND);
+  DrawHand(hourAngle, Real(70));
+#endif
 
-  double hourAngle = ((double)(hour % 12) + minuteNormalized) * 30;
+  RENDER_MESH(MESH_CENTER);
+  fillTriangle(corner1, corner1, corner2, corner2, corner3, corner3, CENTER_SHADOW_SHADER);
+  fillTriangle(corner3, corner3, corner4, corner4, corner1, corner1, CENTER_SHADOW_SHADER);
 
-  DrawHand(hourAngle, 70);
-  DrawHand(minute * 6, 90);
+#if !SPIRAL_FRONT_TO_BACK
+  RENDER_MESH(MESH_HOUR_HAND);
+  DrawHand(hourAngle, Real(70));
+  RENDER_MESH(MESH_MINUTE_HAND);
+  DrawHand(Real(minute * 6), Real(90));
+#endif
 }
 
-void SpiralWatchy::DrawHand(double angle, double size)
+void SpiralWatchy::DrawHand(Real angle, Real size)
 {
-  double radians = angle * DEG_TO_RAD;
-  double sinAngle = sin(radians);
-  double cosAngle = cos(radians);
+  Real radians = angle * Real(DEG_TO_RAD);
+  Real sinAngle = scalarSin(radians);
+  Real cosAngle = scalarCos(radians);
+
+#if SPIRAL_FRONT_TO_BACK
+  // The outline lies on top of the fill.
+  DrawHandOutline(sinAngle, cosAngle, size);
+#endif
 
   for (int i = 0; i < HAND_POS_LEN; i++)
   {
@@ -197,551 +409,310 @@ void SpiralWatchy::DrawHand(double angle, double size)
     Vector v2 = Vector::rotateVector(HAND[HAND_POS_INDEX[i * 3 + 1]], sinAngle, cosAngle) * size + CENTER;
     Vector v3 = Vector::rotateVector(HAND[HAND_POS_INDEX[i * 3 + 2]], sinAngle, cosAngle) * size + CENTER;
 
-    Vector uv1 = Vector::rotateVector(HAND_NORMAL[HAND_NORMAL_INDEX[i * 3]], sinAngle, cosAngle) * 99 + CENTER;
-    Vector uv2 = Vector::rotateVector(HAND_NORMAL[HAND_NORMAL_INDEX[i * 3 + 1]], sinAngle, cosAngle) * 99 + CENTER;
-    Vector uv3 = Vector::rotateVector(HAND_NORMAL[HAND_NORMAL_INDEX[i * 3 + 2]], sinAngle, cosAngle) * 99 + CENTER;
+    Vector uv1 = Vector::rotateVector(HAND_NORMAL[HAND_NORMAL_INDEX[i * 3]], sinAngle, cosAngle) * Real(99) + CENTER;
+    Vector uv2 = Vector::rotateVector(HAND_NORMAL[HAND_NORMAL_INDEX[i * 3 + 1]], sinAngle, cosAngle) * Real(99) + CENTER;
+    Vector uv3 = Vector::rotateVector(HAND_NORMAL[HAND_NORMAL_INDEX[i * 3 + 2]], sinAngle, cosAngle) * Real(99) + CENTER;
 
-    fillTriangle2(v1, uv1, v2, uv2, v3, uv3, MatCapSource, 200, 200);
+    fillTriangle(v1, uv1, v2, uv2, v3, uv3, MATCAP_SHADER);
   }
 
+#if !SPIRAL_FRONT_TO_BACK
+  DrawHandOutline(sinAngle, cosAngle, size);
+#endif
+}
+
+void SpiralWatchy::DrawHandOutline(Real sinAngle, Real cosAngle, Real size)
+{
   for (int i = 0; i < HAND_OUTLINE_LEN; i++)
   {
     Vector v1 = Vector::rotateVector(HAND[HAND_OUTLINE_INDEX[i]], sinAngle, cosAngle) * size + CENTER;
     Vector v2 = Vector::rotateVector(HAND[HAND_OUTLINE_INDEX[(i + 1) % HAND_OUTLINE_LEN]], sinAngle, cosAngle) * size + CENTER;
 
-    display.drawLine(v1.x, v1.y, v2.x, v2.y, GxEPD_BLACK);
+    drawLine(v1, v2, GxEPD_BLACK);
   }
 }
 
-float SpiralWatchy::getBatteryFill()
-{
-  float VBAT = getBatteryVoltage();
-
-  // 12 battery states
-  float batState = ((VBAT - VOLTAGE_MIN) / VOLTAGE_RANGE);
-  if (batState > 1.0)
-    batState = 1.0;
-  if (batState < 0.0)
-    batState = 0;
-
-  return batState;
-}
-
-#ifndef _swap_int16_t
-#define _swap_int16_t(a, b)                                                    \
-  {                                                                            \
-    int16_t t = a;                                                             \
-    a = b;                                                                     \
-    b = t;                                                                     \
-  }
-#endif
-
-#ifndef _swap_vector
-#define _swap_vector(a, b)                                                    \
-  {                                                                            \
-    Vector t = a;                                                             \
-    a = b;                                                                     \
-    b = t;                                                                     \
-  }
-#endif
-
-#ifndef _swap_vector_int
-#define _swap_vector_int(a, b)                                                    \
-  {                                                                            \
-    VectorInt t = a;                                                             \
-    a = b;                                                                     \
-    b = t;                                                                     \
-  }
-#endif
-
-static double clamp(double val, double min, double max)
+void SpiralWatchy::drawLine(Vector v0, Vector v1, uint16_t color)
 {
-  if (val > max)
-    val = max;
-  
-  if (val < min)
-    val = min;
-
-  return val;
+  VectorInt a = v0, b = v1;
+  target.drawLine(a.x, a.y, b.x, b.y, color);
 }
 
-static void barycentric(VectorInt p, VectorInt v0, VectorInt v1, VectorInt a, double invDen, double &u, double &v, double &w)
+void SpiralWatchy::drawTriangle(Vector v0, Vector v1, Vector v2, uint16_t color)
 {
-    VectorInt v2 = p - a;
-    // ToDo: Premultiply v0 and v1 by invDen?
-    v = (v2.x * v1.y - v1.x * v2.y) * invDen;
-    w = (v0.x * v2.y - v2.x * v0.y) * invDen;
-    u = 1.0 - v - w;
+  VectorInt a = v0, b = v1, c = v2;
+  target.drawLine(a.x, a.y, b.x, b.y, color);
+  target.drawLine(b.x, b.y, c.x, c.y, color);
+  target.drawLine(c.x, c.y, a.x, a.y, color);
 }
 
+#if SPIRAL_BENCHMARK
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
 
-static bool getColor(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h) 
+static uint32_t cycleCount()
 {
-  int16_t byteWidth = (w + 7) / 8;
-  return (pgm_read_byte(bitmap + y * byteWidth + x / 8) & (128 >> (x & 7)));
+  return (uint32_t)__rdtsc();
 }
-
-void SpiralWatchy::drawLine(int x, int y, int w, VectorInt v0, Vector uv0, VectorInt a, Vector uv1, VectorInt b, Vector uv2, double invDen, const uint8_t *bitmap, int16_t bw, int16_t bh)
+#else
+static uint32_t cycleCount()
 {
-  for (int i = 0; i < w; i++)
-  {
-    double ua, va, wa;
-    VectorInt pointA = {x + i, y};
-    barycentric(pointA, a, b, v0, invDen, ua, va, wa);
-
-    Vector uv = uv0 * ua + uv1 * va + uv2 * wa;
-
-    bool white = getColor(uv.x, uv.y, bitmap, bw, bh);
-    display.drawPixel(x + i, y, white ? GxEPD_WHITE : GxEPD_BLACK);
-  }
+  return ESP.getCycleCount();
 }
+#endif
 
-void SpiralWatchy::fillTriangle(VectorInt v0, Vector uv0, VectorInt v1, Vector uv1, VectorInt v2, Vector uv2, const uint8_t bitmap[], int w, int h)
+#if SPIRAL_KERNEL != SPIRAL_KERNEL_SCALAR
+// The face texture mapped 1:1 onto every byte of the screen, dithered once
+// pixel by pixel through the shader, once through the packed kernel and once
+// in whole rows through the vector kernel where there is one, to time the
+// kernels on their own and check that they agree. The fastest of several
+// passes counts, so interrupts and cold caches stay out of it. Returns whether
+// all three agree.
+static bool benchmarkDitherKernel()
 {
-  int16_t a, b, y, last;
-  Vector uvA, uvB;
-
-  // Sort coordinates by Y order (y2 >= y1 >= y0)
-  if (v0.y > v1.y) {
-    _swap_vector_int(v0, v1);
-    _swap_vector(uv0, uv1);
-  }
-  if (v1.y > v2.y) {
-    _swap_vector_int(v2, v1);
-    _swap_vector(uv2, uv1);
-  }
-  if (v0.y > v1.y) {
-    _swap_vector_int(v0, v1);
-    _swap_vector(uv0, uv1);
-  }
+  const int PASSES = 10;
+  static uint8_t scalar[FrameBuffer::STRIDE * SCREEN_HEIGHT], packed[FrameBuffer::STRIDE * SCREEN_HEIGHT],
+      rows[FrameBuffer::STRIDE * SCREEN_HEIGHT];
+  uint32_t scalarCycles = UINT32_MAX, packedCycles = UINT32_MAX, rowCycles = UINT32_MAX;
 
-  display.startWrite();
-  if (v0.y == v2.y) { // Handle awkward all-on-same-line case as its own thing
-    a = b = v0.x;
-    uvA = uv0;
-    uvB = uv0;
+  for (int pass = 0; pass < PASSES; pass++)
+  {
+    uint32_t start = cycleCount();
 
-    if (v1.x < a)
+    for (int y = 0; y < SCREEN_HEIGHT; y++)
     {
-      a = v1.x;
-      uvA = uv1;
-    }
-    else if (v1.x > b)
-    { 
-      b = v1.x;
-      uvB = uv1;
-    }
-    if (v2.x < a)
-    {
-      a = v2.x;
-      uvA = uv2;
-    }
-    else if (v2.x > b)
-    {
-      b = v2.x;
-      uvB = uv2;
+      for (int x = 0; x < SCREEN_WIDTH; x += 8)
+      {
+        uint8_t bits = 0;
+
+        for (int i = 0; i < 8; i++)
+        {
+          uint16_t color;
+          FACE_SHADER(x + i, y, x + i, y, color);
+          if (color)
+            bits |= 0x80 >> i;
+        }
+
+        scalar[y * FrameBuffer::STRIDE + x / 8] = bits;
+      }
     }
 
-    writeFastHLineUV(a, v0.y, b - a + 1, uvA, uvB, bitmap, w, h);
-    display.endWrite();
-    return;
-  }
+    uint32_t middle = cycleCount();
 
-  int16_t dx01 = v1.x - v0.x, dy01 = v1.y - v0.y, 
-          dx02 = v2.x - v0.x, dy02 = v2.y - v0.y,
-          dx12 = v2.x - v1.x, dy12 = v2.y - v1.y;
-  int32_t sa = 0, sb = 0;
-
-  // For upper part of triangle, find scanline crossings for segments
-  // 0-1 and 0-2.  If y1=y2 (flat-bottomed triangle), the scanline y1
-  // is included here (and second loop will be skipped, avoiding a /0
-  // error there), otherwise scanline y1 is skipped here and handled
-  // in the second loop...which also avoids a /0 error here if y0=y1
-  // (flat-topped triangle).
-  if (v1.y == v2.y)
-    last = v1.y; // Include y1 scanline
-  else
-    last = v1.y - 1; // Skip it
-
-    
-  VectorInt aa = v1 - v0, bb = v2 - v0;
-  double invDen = 1 / VectorInt::crossProduct(aa, bb);
-
-  int startY = v0.y;
-
-  for (y = startY; y <= last; y++) {
-    a = v0.x + sa / dy01;
-    b = v0.x + sb / dy02;
-
-    sa += dx01;
-    sb += dx02;
-
-    
-    /* longhand:
-    a = x0 + (x1 - x0) * (y - y0) / (y1 - y0);
-    b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-    */
-    if (a > b)
-      _swap_int16_t(a, b);
-
-    if (y >= 0 && y < 200)
-      drawLine(a, y, b - a + 1, v0, uv0, aa, uv1, bb, uv2, invDen, bitmap, w, h);
-  }
-
-  // For lower part of triangle, find scanline crossings for segments
-  // 0-2 and 1-2.  This loop is skipped if y1=y2.
-  sa = (int32_t)dx12 * (y - v1.y);
-  sb = (int32_t)dx02 * (y - v0.y);
-  
-  int endY = v2.y;
-
-  if (endY > 200)
-    endY = 200;
-
-  for (; y <= endY; y++) {
-    a = v1.x + sa / dy12;
-    b = v0.x + sb / dy02;
+    for (int y = 0; y < SCREEN_HEIGHT; y++)
+    {
+      for (int x = 0; x < SCREEN_WIDTH; x += 8)
+      {
+        uint8_t mask;
+        shadeByte(FACE_SHADER, x, y, x * Fixed::ONE, y * Fixed::ONE, Fixed::ONE, 0,
+                  packed[y * FrameBuffer::STRIDE + x / 8], mask);
+      }
+    }
 
-    sa += dx12;
-    sb += dx02;
+    uint32_t packedEnd = cycleCount();
 
-    /* longhand:
-    a = x1 + (x2 - x1) * (y - y1) / (y2 - y1);
-    b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-    */
-    if (a > b)
-      _swap_int16_t(a, b);
+    // What the vector kernel leaves over goes through the packed one.
+    for (int y = 0; y < SCREEN_HEIGHT; y++)
+    {
+      uint8_t *row = rows + y * FrameBuffer::STRIDE;
+      int done = shadeBytes(FACE_SHADER, 0, y, 0, y * Fixed::ONE, Fixed::ONE, 0, row, FrameBuffer::STRIDE);
+
+      for (int b = done; b < FrameBuffer::STRIDE; b++)
+      {
+        uint8_t mask;
+        shadeByte(FACE_SHADER, b * 8, y, b * 8 * Fixed::ONE, y * Fixed::ONE, Fixed::ONE, 0, row[b], mask);
+      }
+    }
 
-    if (y >= 0)
-      drawLine(a, y, b - a + 1, v0, uv0, aa, uv1, bb, uv2, invDen, bitmap, w, h);
-  }
-  display.endWrite();
+    uint32_t end = cycleCount();
+
+    if (middle - start < scalarCycles)
+      scalarCycles = middle - start;
+    if (packedEnd - middle < packedCycles)
+      packedCycles = packedEnd - middle;
+    if (end - packedEnd < rowCycles)
+      rowCycles = end - packedEnd;
+  }
+
+  // Tenths of a cycle.
+  const int BYTES = FrameBuffer::STRIDE * SCREEN_HEIGHT;
+  bool identical = memcmp(scalar, packed, sizeof(scalar)) == 0 && memcmp(scalar, rows, sizeof(scalar)) == 0;
+  Serial.printf("dither kernel: %lu.%lu cycles per byte pixel by pixel, %lu.%lu packed, %lu.%lu in rows, %s\n",
+                (unsigned long)(scalarCycles * 10 / BYTES / 10), (unsigned long)(scalarCycles * 10 / BYTES % 10),
+                (unsigned long)(packedCycles * 10 / BYTES / 10), (unsigned long)(packedCycles * 10 / BYTES % 10),
+                (unsigned long)(rowCycles * 10 / BYTES / 10), (unsigned long)(rowCycles * 10 / BYTES % 10),
+                identical ? "identical" : "DIFFERENT");
+  return identical;
 }
+#endif
 
-void SpiralWatchy::writeFastHLineUV(int16_t x, int16_t y, int16_t w, Vector uvA, Vector uvB, const uint8_t bitmap[], int bw, int bh)
+bool SpiralWatchy::benchmarkWatchFace()
 {
-  display.startWrite();
+  bool identical = true;
+  // Fixed sweep of times, so every build configuration renders the same frames.
+  const int FRAMES = 60;
+  tmElements_t savedTime = currentTime;
+
+  renderStats = RenderStats();
+  unsigned long start = micros();
 
-  for (int i = 0; i < w; i++)
+  for (int i = 0; i < FRAMES; i++)
   {
-    double lerpVal = i / (w + 1.0);
-    Vector uv = (uvA * lerpVal) + (uvB * (1.0 - lerpVal));
-    bool white = getColor(uv.x, uv.y, bitmap, bw, bh);
-    display.drawPixel(x + i, y, white ? GxEPD_WHITE : GxEPD_BLACK);
+    currentTime.Hour = 10;
+    currentTime.Minute = i;
+    drawWatchFace();
   }
 
-  display.endWrite();
-}
-
-static bool getColor2(int16_t x, int16_t y, int16_t xUv, int16_t yUv, const uint8_t *bitmap, int16_t w, int16_t h) 
-{
-  return bitmap[yUv * w + xUv] > BlueNoise200[y * 200 + x];
-}
-
-void SpiralWatchy::drawLine2(int x, int y, int w, VectorInt v0, Vector uv0, VectorInt a, Vector uv1, VectorInt b, Vector uv2, double invDen, const uint8_t *bitmap, int16_t bw, int16_t bh)
-{
-  for (int i = 0; i < w; i++)
-  {
-    double ua, va, wa;
-    VectorInt pointA = {x + i, y};
-    barycentric(pointA, a, b, v0, invDen, ua, va, wa);
+  unsigned long elapsed = micros() - start;
+  currentTime = savedTime;
 
-    Vector uv = uv0 * ua + uv1 * va + uv2 * wa;
+  Serial.printf("SPIRAL_PRECISION=%d SPIRAL_RENDERER=%d SPIRAL_BANDS=%d: %lu us per frame over %d frames\n",
+                SPIRAL_PRECISION, SPIRAL_RENDERER, SPIRAL_BANDS, elapsed / FRAMES, FRAMES);
+  Serial.printf("%lu shaded pixels per frame, %lu pixels per second\n", (unsigned long)(renderStats.shadedPixels / FRAMES),
+                (unsigned long)((uint64_t)renderStats.shadedPixels * 1000000 / elapsed));
+#if SPIRAL_DITHER_BOUNDS
+  Serial.printf("%lu%% of them settled a byte at a time by texture and noise bounds\n",
+                (unsigned long)((uint64_t)renderStats.runPixels * 100 / renderStats.shadedPixels));
+#endif
+  Serial.printf("per frame: %lu triangles, %lu culled, %lu guard band clips, %lu rows and %lu pixels clipped\n",
+                (unsigned long)(renderStats.triangles / FRAMES), (unsigned long)(renderStats.culledTriangles / FRAMES),
+                (unsigned long)(renderStats.guardBandClips / FRAMES), (unsigned long)(renderStats.clippedRows / FRAMES),
+                (unsigned long)(renderStats.clippedPixels / FRAMES));
+#if SPIRAL_TEXTURE_ADDRESS != SPIRAL_ADDRESS_NONE
+  Serial.printf("%lu spans per frame reaching past their texture\n",
+                (unsigned long)(renderStats.addressedSpans / FRAMES));
+#endif
+#if SPIRAL_MIPMAPS
+  Serial.printf("triangles per frame by mip level:");
+  for (int level = 0; level < MIPS_200.levels; level++)
+    Serial.printf(" %lu", (unsigned long)(renderStats.mipTriangles[level] / FRAMES));
+  Serial.printf("\n");
+#endif
+#if SPIRAL_CACHE_MODEL
+  Serial.printf("%lu texture reads per frame, %lu of them flash cache misses (%d KB, %d way, %d byte lines)\n",
+                (unsigned long)(renderStats.textureFetches / FRAMES), (unsigned long)(renderStats.cacheMisses / FRAMES),
+                CACHE_SETS * CACHE_WAYS * CACHE_LINE / 1024, CACHE_WAYS, CACHE_LINE);
+#endif
+#if SPIRAL_FRONT_TO_BACK
+  Serial.printf("%lu pixels per frame skipped behind the hands and the center square\n",
+                (unsigned long)(renderStats.occludedPixels / FRAMES));
+#endif
+  Serial.printf("per frame: %lu scanned, %lu point sampled and %lu zero area triangles\n",
+                (unsigned long)(renderStats.scannedTriangles / FRAMES), (unsigned long)(renderStats.smallTriangles / FRAMES),
+                (unsigned long)(renderStats.zeroAreaTriangles / FRAMES));
+  // Separate triangles would snap all three vertices and set up all three
+  // edges each.
+  Serial.printf("per frame: %lu strip triangles from %lu vertices (%lu vertex setups saved), %lu edge setups "
+                "(%lu saved)\n",
+                (unsigned long)(renderStats.stripTriangles / FRAMES), (unsigned long)(renderStats.stripVertices / FRAMES),
+                (unsigned long)((renderStats.stripTriangles * 3 - renderStats.stripVertices) / FRAMES),
+                (unsigned long)(renderStats.edgeSetups / FRAMES), (unsigned long)(renderStats.sharedEdges / FRAMES));
+
+#if SPIRAL_BANDS == SPIRAL_BANDS_POLYGONS
+  Serial.printf("per frame: %lu polygon edges, %lu polygon spans\n", (unsigned long)(renderStats.polygonEdges / FRAMES),
+                (unsigned long)(renderStats.polygonSpans / FRAMES));
+#endif
 
-    bool white = getColor2(x + i, y, uv.x, uv.y, bitmap, bw, bh);
-    display.drawPixel(x + i, y, white ? GxEPD_WHITE : GxEPD_BLACK);
-  }
-}
+#if SPIRAL_RENDERER == SPIRAL_RENDERER_TILED
+  Serial.printf("per frame: %lu full, %lu partial and %lu empty 8x8 blocks, %lu extra passes\n",
+                (unsigned long)(renderStats.tileBlocksFull / FRAMES), (unsigned long)(renderStats.tileBlocksPartial / FRAMES),
+                (unsigned long)(renderStats.tileBlocksEmpty / FRAMES), (unsigned long)(renderStats.tileFlushes / FRAMES));
+#elif SPIRAL_RENDERER == SPIRAL_RENDERER_SCANLINE
+  Serial.printf("%lu sweeps over %d frames\n", (unsigned long)renderStats.scanlineSweeps, FRAMES);
+#elif SPIRAL_RENDERER == SPIRAL_RENDERER_VISIBILITY
+  if (!target.deferred())
+    Serial.println("visibility buffer: no heap for the ID and texel buffers, shaded immediately");
+  Serial.printf("%lu texels resolved per frame\n", (unsigned long)(renderStats.resolvedPixels / FRAMES));
+#endif
 
-void SpiralWatchy::fillTriangle2(VectorInt v0, Vector uv0, VectorInt v1, Vector uv1, VectorInt v2, Vector uv2, const uint8_t bitmap[], int w, int h)
-{
-  int16_t a, b, y, last;
-  Vector uvA, uvB;
+#if SPIRAL_KERNEL != SPIRAL_KERNEL_SCALAR
+  identical = benchmarkDitherKernel();
+#endif
 
-  // Sort coordinates by Y order (y2 >= y1 >= y0)
-  if (v0.y > v1.y) {
-    _swap_vector_int(v0, v1);
-    _swap_vector(uv0, uv1);
-  }
-  if (v1.y > v2.y) {
-    _swap_vector_int(v2, v1);
-    _swap_vector(uv2, uv1);
-  }
-  if (v0.y > v1.y) {
-    _swap_vector_int(v0, v1);
-    _swap_vector(uv0, uv1);
-  }
+#if SPIRAL_X86_SIMD
+  // The same sweep at every vector level the CPU has, scalar first.
+  static const char *const SIMD_NAMES[] = {"scalar", "SSE2", "AVX2"};
+  int savedLevel = simdLevel();
 
-  display.startWrite();
-  if (v0.y == v2.y) { // Handle awkward all-on-same-line case as its own thing
-    a = b = v0.x;
-    uvA = uv0;
-    uvB = uv0;
+  for (int level = SPIRAL_SIMD_NONE; level <= supportedSimdLevel(); level++)
+  {
+    setSimdLevel(level);
+    unsigned long levelStart = micros();
 
-    if (v1.x < a)
-    {
-      a = v1.x;
-      uvA = uv1;
-    }
-    else if (v1.x > b)
-    { 
-      b = v1.x;
-      uvB = uv1;
-    }
-    if (v2.x < a)
-    {
-      a = v2.x;
-      uvA = uv2;
-    }
-    else if (v2.x > b)
+    for (int i = 0; i < FRAMES; i++)
     {
-      b = v2.x;
-      uvB = uv2;
+      currentTime.Hour = 10;
+      currentTime.Minute = i;
+      drawWatchFace();
     }
 
-    writeFastHLineUV2(a, v0.y, b - a + 1, uvA, uvB, bitmap, w, h);
-    display.endWrite();
-    return;
-  }
-
-  int16_t dx01 = v1.x - v0.x, dy01 = v1.y - v0.y, 
-          dx02 = v2.x - v0.x, dy02 = v2.y - v0.y,
-          dx12 = v2.x - v1.x, dy12 = v2.y - v1.y;
-  int32_t sa = 0, sb = 0;
-
-  // For upper part of triangle, find scanline crossings for segments
-  // 0-1 and 0-2.  If y1=y2 (flat-bottomed triangle), the scanline y1
-  // is included here (and second loop will be skipped, avoiding a /0
-  // error there), otherwise scanline y1 is skipped here and handled
-  // in the second loop...which also avoids a /0 error here if y0=y1
-  // (flat-topped triangle).
-  if (v1.y == v2.y)
-    last = v1.y; // Include y1 scanline
-  else
-    last = v1.y - 1; // Skip it
-
-    
-  VectorInt aa = v1 - v0, bb = v2 - v0;
-  double invDen = 1 / VectorInt::crossProduct(aa, bb);
-
-  int startY = v0.y;
-
-  for (y = startY; y <= last; y++) {
-    a = v0.x + sa / dy01;
-    b = v0.x + sb / dy02;
-
-    sa += dx01;
-    sb += dx02;
-
-    
-    /* longhand:
-    a = x0 + (x1 - x0) * (y - y0) / (y1 - y0);
-    b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-    */
-    if (a > b)
-      _swap_int16_t(a, b);
-
-    if (y >= 0 && y < 200)
-      drawLine2(a, y, b - a + 1, v0, uv0, aa, uv1, bb, uv2, invDen, bitmap, w, h);
+    // Tenths of a frame.
+    unsigned long tenths = (unsigned long)((uint64_t)FRAMES * 10000000 / (micros() - levelStart));
+    Serial.printf("%s: %lu.%lu frames per second\n", SIMD_NAMES[level], tenths / 10, tenths % 10);
   }
 
-  // For lower part of triangle, find scanline crossings for segments
-  // 0-2 and 1-2.  This loop is skipped if y1=y2.
-  sa = (int32_t)dx12 * (y - v1.y);
-  sb = (int32_t)dx02 * (y - v0.y);
- 
-  int endY = v2.y;
-
-  if (endY > 200)
-    endY = 200;
-
-  for (; y <= endY; y++) {
-    a = v1.x + sa / dy12;
-    b = v0.x + sb / dy02;
+  setSimdLevel(savedLevel);
+  currentTime = savedTime;
+#endif
 
-    sa += dx12;
-    sb += dx02;
+#if SPIRAL_OVERDRAW
+  OverdrawReport overdraw = measureOverdraw();
 
-    /* longhand:
-    a = x1 + (x2 - x1) * (y - y1) / (y2 - y1);
-    b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-    */
-    if (a > b)
-      _swap_int16_t(a, b);
+  Serial.printf("overdraw over 1440 minutes: %lu pixels, worst frame %lu\n", (unsigned long)overdraw.overdrawnPixels,
+                (unsigned long)overdraw.worstFrame);
+  Serial.printf("shader runs per frame: %lu, %lu of them on pixels shaded again\n",
+                (unsigned long)(overdraw.shaderRuns / 1440), (unsigned long)(overdraw.wastedRuns / 1440));
+#endif
 
-    if (y >= 0)
-      drawLine2(a, y, b - a + 1, v0, uv0, aa, uv1, bb, uv2, invDen, bitmap, w, h);
-  }
-  display.endWrite();
+  return identical;
 }
 
-void SpiralWatchy::writeFastHLineUV2(int16_t x, int16_t y, int16_t w, Vector uvA, Vector uvB, const uint8_t bitmap[], int bw, int bh)
+#if SPIRAL_OVERDRAW
+SpiralWatchy::OverdrawReport SpiralWatchy::measureOverdraw()
 {
-  display.startWrite();
+  // Every minute of the day, each starting from a frame no mesh owns yet.
+  OverdrawReport report = {};
+  tmElements_t savedTime = currentTime;
 
-  for (int i = 0; i < w; i++)
+  for (int i = 0; i < 24 * 60; i++)
   {
-    double lerpVal = i / (w + 1.0);
-    Vector uv = (uvA * lerpVal) + (uvB * (1.0 - lerpVal));
-    bool white = getColor2(x + i, y, uv.x, uv.y, bitmap, bw, bh);
-    display.drawPixel(x + i, y, white ? GxEPD_WHITE : GxEPD_BLACK);
-  }
+    currentTime.Hour = i / 60;
+    currentTime.Minute = i % 60;
 
-  display.endWrite();
-}
+    renderStats.overdrawnPixels = 0;
+    memset(renderStats.owner, MESH_NONE, sizeof(renderStats.owner));
+    memset(renderStats.shaderRuns, 0, sizeof(renderStats.shaderRuns));
+    drawWatchFace();
 
-void SpiralWatchy::drawLine(int x, int y, int w, VectorInt v0, Vector uv0, VectorInt a, Vector uv1, VectorInt b, Vector uv2, double invDen, const uint8_t *bitmap, int16_t bw, int16_t bh, uint16_t color)
-{
-  for (int i = 0; i < w; i++)
-  {
-    double ua, va, wa;
-    VectorInt pointA = {x + i, y};
-    barycentric(pointA, a, b, v0, invDen, ua, va, wa);
+    report.overdrawnPixels += renderStats.overdrawnPixels;
+    if (renderStats.overdrawnPixels > report.worstFrame)
+      report.worstFrame = renderStats.overdrawnPixels;
 
-    Vector uv = uv0 * ua + uv1 * va + uv2 * wa;
-
-    bool draw = getColor2(x + i, y, uv.x, uv.y, bitmap, bw, bh);
-
-    if (!draw)
-      display.drawPixel(x + i, y, color);
-  }
-}
-
-void SpiralWatchy::fillTriangle(VectorInt v0, Vector uv0, VectorInt v1, Vector uv1, VectorInt v2, Vector uv2, const uint8_t bitmap[], int w, int h, uint16_t color)
-{
-  int16_t a, b, y, last;
-  Vector uvA, uvB;
-
-  // Sort coordinates by Y order (y2 >= y1 >= y0)
-  if (v0.y > v1.y) {
-    _swap_vector_int(v0, v1);
-    _swap_vector(uv0, uv1);
-  }
-  if (v1.y > v2.y) {
-    _swap_vector_int(v2, v1);
-    _swap_vector(uv2, uv1);
-  }
-  if (v0.y > v1.y) {
-    _swap_vector_int(v0, v1);
-    _swap_vector(uv0, uv1);
-  }
-
-  display.startWrite();
-  if (v0.y == v2.y) { // Handle awkward all-on-same-line case as its own thing
-    a = b = v0.x;
-    uvA = uv0;
-    uvB = uv0;
-
-    if (v1.x < a)
+    // Only the last run on a pixel can decide what it shows.
+    for (int p = 0; p < SCREEN_WIDTH * SCREEN_HEIGHT; p++)
     {
-      a = v1.x;
-      uvA = uv1;
+      report.shaderRuns += renderStats.shaderRuns[p];
+      if (renderStats.shaderRuns[p] > 1)
+        report.wastedRuns += renderStats.shaderRuns[p] - 1;
     }
-    else if (v1.x > b)
-    { 
-      b = v1.x;
-      uvB = uv1;
-    }
-    if (v2.x < a)
-    {
-      a = v2.x;
-      uvA = uv2;
-    }
-    else if (v2.x > b)
-    {
-      b = v2.x;
-      uvB = uv2;
-    }
-
-    writeFastHLineUV(a, v0.y, b - a + 1, uvA, uvB, bitmap, w, h, color);
-    display.endWrite();
-    return;
-  }
-
-  int16_t dx01 = v1.x - v0.x, dy01 = v1.y - v0.y, 
-          dx02 = v2.x - v0.x, dy02 = v2.y - v0.y,
-          dx12 = v2.x - v1.x, dy12 = v2.y - v1.y;
-  int32_t sa = 0, sb = 0;
-
-  // For upper part of triangle, find scanline crossings for segments
-  // 0-1 and 0-2.  If y1=y2 (flat-bottomed triangle), the scanline y1
-  // is included here (and second loop will be skipped, avoiding a /0
-  // error there), otherwise scanline y1 is skipped here and handled
-  // in the second loop...which also avoids a /0 error here if y0=y1
-  // (flat-topped triangle).
-  if (v1.y == v2.y)
-    last = v1.y; // Include y1 scanline
-  else
-    last = v1.y - 1; // Skip it
-
-    
-  VectorInt aa = v1 - v0, bb = v2 - v0;
-  double invDen = 1 / VectorInt::crossProduct(aa, bb);
-
-  int startY = v0.y;
-
-  for (y = startY; y <= last; y++) {
-    a = v0.x + sa / dy01;
-    b = v0.x + sb / dy02;
-
-    sa += dx01;
-    sb += dx02;
-
-    
-    /* longhand:
-    a = x0 + (x1 - x0) * (y - y0) / (y1 - y0);
-    b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-    */
-    if (a > b)
-      _swap_int16_t(a, b);
-
-    if (y >= 0 && y < 200)
-      drawLine(a, y, b - a + 1, v0, uv0, aa, uv1, bb, uv2, invDen, bitmap, w, h, color);
   }
 
-  // For lower part of triangle, find scanline crossings for segments
-  // 0-2 and 1-2.  This loop is skipped if y1=y2.
-  sa = (int32_t)dx12 * (y - v1.y);
-  sb = (int32_t)dx02 * (y - v0.y);
-
-  int endY = v2.y;
-
-  if (endY > 200)
-    endY = 200;
-
-  for (; y <= endY; y++) {
-    a = v1.x + sa / dy12;
-    b = v0.x + sb / dy02;
-
-    sa += dx12;
-    sb += dx02;
-
-    /* longhand:
-    a = x1 + (x2 - x1) * (y - y1) / (y2 - y1);
-    b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-    */
-    if (a > b)
-      _swap_int16_t(a, b);
-
-    if (y >= 0)
-      drawLine(a, y, b - a + 1, v0, uv0, aa, uv1, bb, uv2, invDen, bitmap, w, h, color);
-  }
-  display.endWrite();
+  currentTime = savedTime;
+  return report;
 }
+#endif
+#endif
 
-void SpiralWatchy::writeFastHLineUV(int16_t x, int16_t y, int16_t w, Vector uvA, Vector uvB, const uint8_t bitmap[], int bw, int bh, uint16_t color)
+float SpiralWatchy::getBatteryFill()
 {
-  display.startWrite();
-
-  for (int i = 0; i < w; i++)
-  {
-    double lerpVal = i / (w + 1.0);
-    Vector uv = (uvA * lerpVal) + (uvB * (1.0 - lerpVal));
-    bool draw = getColor2(x + i, y, uv.x, uv.y, bitmap, bw, bh);
+  float VBAT = getBatteryVoltage();
 
-    if (!draw)
-      display.drawPixel(x + i, y, color);
-  }
+  // 12 battery states
+  float batState = ((VBAT - VOLTAGE_MIN) / VOLTAGE_RANGE);
+  if (batState > 1.0)
+    batState = 1.0;
+  if (batState < 0.0)
+    batState = 0;
 
-  display.endWrite();
-}
\ No newline at end of file
+  return batState;
+}
@@ -2,12 +2,12 @@
 
 #include <Watchy.h>
 #include "../include/images.h"
-#include "../include/MatCapSource.h"
-#include "Vector.h"
-#include "../include/BlueNoise200.h"
-#include "../include/SpiralFaceShadow.h"
-#include "../include/SpiralFaceShadowCenter.h"
-#include "../include/SpiralFaceWithShadow.h"
+#include "RenderConfig.h"
+#include "Rasterizer.h"
+#include "Renderer.h"
+#include "PolygonFiller.h"
+#include "Shaders.h"
+#include "../include/Textures.h"
 
 class SpiralWatchy : public Watchy
 {
@@ -17,29 +17,45 @@ public:
 
   float getBatteryFill();
 
+#if SPIRAL_BENCHMARK
+  // Returns false when the dither kernels disagree with the shader.
+  bool benchmarkWatchFace();
+
+#if SPIRAL_OVERDRAW
+  // Totals over all 1440 minutes of the day.
+  struct OverdrawReport
+  {
+    uint32_t overdrawnPixels;   // pixels a mesh covered more than once
+    uint32_t worstFrame;        // overdrawn pixels of the worst minute
+    uint32_t shaderRuns;
+    uint32_t wastedRuns;        // runs on pixels shaded again later
+  };
+
+  OverdrawReport measureOverdraw();
+#endif
+#endif
+
   void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
                               int16_t w, int16_t h, uint16_t color, bool even);
 
 
-  void DrawHand(double angle, double size);                           
-  void fillTriangle(VectorInt v0, Vector uv0, VectorInt v1, Vector uv1, VectorInt v2, Vector uv2, const uint8_t bitmap[], int w, int h);
-  
-   void drawLine(int x, int y, int w, VectorInt v0, Vector uv0, VectorInt a, Vector uv1, VectorInt b, Vector uv2, double den, const uint8_t *bitmap, int16_t bw, int16_t bh);
-
-                                
-  void writeFastHLineUV(int16_t x, int16_t y, int16_t w, Vector uvA, Vector uvB, const uint8_t bitmap[], int bw, int bh);
+  void drawForeground(int hour, int minute, Real minuteNormalized);
+  void DrawHand(Real angle, Real size);
+  void DrawHandOutline(Real sinAngle, Real cosAngle, Real size);
+  void drawLine(Vector v0, Vector v1, uint16_t color);
+  void drawTriangle(Vector v0, Vector v1, Vector v2, uint16_t color);
 
-  void fillTriangle2(VectorInt v0, Vector uv0, VectorInt v1, Vector uv1, VectorInt v2, Vector uv2, const uint8_t bitmap[], int w, int h);
-  
-  void drawLine2(int x, int y, int w, VectorInt v0, Vector uv0, VectorInt a, Vector uv1, VectorInt b, Vector uv2, double den, const uint8_t *bitmap, int16_t bw, int16_t bh);
-            
-  void writeFastHLineUV2(int16_t x, int16_t y, int16_t w, Vector uvA, Vector uvB, const uint8_t bitmap[], int bw, int bh);
+  template <typename Shader>
+  void fillTriangle(Vector v0, Vector uv0, Vector v1, Vector uv1, Vector v2, Vector uv2, const Shader& shader)
+  {
+    rasterizeTriangle(target, RasterVertex::from(v0, uv0), RasterVertex::from(v1, uv1), RasterVertex::from(v2, uv2), shader);
+  }
 
-  
+private:
+  RenderTarget target;
 
-  void fillTriangle(VectorInt v0, Vector uv0, VectorInt v1, Vector uv1, VectorInt v2, Vector uv2, const uint8_t bitmap[], int w, int h, uint16_t color);
-  
-  void drawLine(int x, int y, int w, VectorInt v0, Vector uv0, VectorInt a, Vector uv1, VectorInt b, Vector uv2, double den, const uint8_t *bitmap, int16_t bw, int16_t bh, uint16_t color);
-            
-  void writeFastHLineUV(int16_t x, int16_t y, int16_t w, Vector uvA, Vector uvB, const uint8_t bitmap[], int bw, int bh, uint16_t color);
+#if SPIRAL_BANDS == SPIRAL_BANDS_POLYGONS
+  // Both edges of three spiral turns, plus the two closing edges.
+  PolygonFiller<384> polygon;
+#endif
 };
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <Arduino.h>
+#include "RenderStats.h"
+#include "Fixed.h"
+
+// What textures hold their texels by. With SPIRAL_TEXTURE_PARTITION the
+// packed blobs are pointers that mapTextures() only sets at startup, so
+// textures refer to the pointers in Textures.h instead of copying them, and
+// the shaders made from them stay constants.
+#if SPIRAL_TEXTURE_PARTITION
+typedef const uint8_t *const& TextureData;
+#else
+typedef const uint8_t *TextureData;
+#endif
+
+// For the optional blobs a texture goes without.
+const uint8_t *const NO_TEXTURE = nullptr;
+
+constexpr int log2Of(int n)
+{
+    return n <= 1 ? 0 : 1 + log2Of(n / 2);
+}
+
+// Layout of a mip chain atlas from AssetCompiler --mips: level 0, width by
+// height texels, at the origin, and every further level half the size of the
+// one before, rounded up, stacked top to bottom in a column right of it.
+//
+// Triangles carry the texture coordinates of their level with u moved by
+// LEVEL_SPACING texels per level, not the coordinates in the atlas, so that
+// the sampler can still tell the level of a span whose coordinates strayed
+// past its edge, by up to half the spacing, and address it within the level
+// (Sampler.h).
+struct MipChain
+{
+    static const int LEVEL_SPACING = 2048;
+
+    int16_t width, height;
+    uint8_t levels;
+
+    // The level a u coordinate of a triangle belongs to, with the coordinate
+    // moved back onto the level.
+    int level(int32_t& u) const
+    {
+        const int32_t SPACING = LEVEL_SPACING << Fixed::FRACTION_BITS;
+        int l = (u + SPACING / 2) >> (log2Of(LEVEL_SPACING) + Fixed::FRACTION_BITS);
+
+        l = l < 0 ? 0 : l >= levels ? levels - 1 : l;
+        u -= l * SPACING;
+        return l;
+    }
+
+    void size(int level, int& w, int& h) const
+    {
+        w = (width + (1 << level) - 1) >> level;
+        h = (height + (1 << level) - 1) >> level;
+    }
+
+    // Top left texel of a level in the atlas.
+    void origin(int level, int& u, int& v) const
+    {
+        u = level ? width : 0;
+        v = 0;
+
+        for (int l = 1, h = (height + 1) / 2; l < level; l++, h = (h + 1) / 2)
+            v += h;
+    }
+};
+
+constexpr int powerOfTwoAbove(int n)
+{
+    return n <= 1 ? 1 : 2 * powerOfTwoAbove((n + 1) / 2);
+}
+
+// The bits of x moved apart to every other bit, for Morton order.
+constexpr uint32_t spreadBits(uint32_t x)
+{
+    return x ? (x & 1) | spreadBits(x >> 1) << 2 : 0;
+}
+
+// Where each texel of a W by H texture is stored, for the layouts of
+// SPIRAL_TEXTURE_LAYOUT. SIZE is the number of bytes the layout takes,
+// padding included.
+template <int Layout, int W, int H>
+struct TexelLayout;
+
+template <int W, int H>
+struct TexelLayout<SPIRAL_LAYOUT_ROWS, W, H>
+{
+    static const int SIZE = W * H;
+
+    static int index(int u, int v) { return v * W + u; }
+};
+
+// Rows start every power of two texels, so finding one is a shift.
+template <int W, int H>
+struct TexelLayout<SPIRAL_LAYOUT_PADDED, W, H>
+{
+    static const int SHIFT = log2Of(powerOfTwoAbove(W));
+    static const int SIZE = H << SHIFT;
+
+    static int index(int u, int v) { return (v << SHIFT) + u; }
+};
+
+// T by T tiles, each row major, stored row major. Spans walking the texture
+// diagonally stay inside a tile, a few cache lines, for several texels.
+template <int T, int W, int H>
+struct TiledLayout
+{
+    static const int SHIFT = log2Of(T);
+    static const int COLUMNS = (W + T - 1) / T;
+    static const int SIZE = COLUMNS * ((H + T - 1) / T) * T * T;
+
+    static int index(int u, int v)
+    {
+        int tile = (v >> SHIFT) * COLUMNS + (u >> SHIFT);
+        return (tile << (2 * SHIFT)) + ((v & (T - 1)) << SHIFT) + (u & (T - 1));
+    }
+};
+
+template <int W, int H>
+struct TexelLayout<SPIRAL_LAYOUT_TILED4, W, H> : TiledLayout<4, W, H>
+{
+};
+
+template <int W, int H>
+struct TexelLayout<SPIRAL_LAYOUT_TILED8, W, H> : TiledLayout<8, W, H>
+{
+};
+
+// The bits of u and v interleaved, v's above u's, so texels close in both
+// directions are close in memory at every scale. Up to 256 by 256 texels;
+// the layout runs up to the index of the last texel.
+template <int W, int H>
+struct TexelLayout<SPIRAL_LAYOUT_MORTON, W, H>
+{
+    static_assert(W <= 256 && H <= 256, "Morton indices are built from 8 bit coordinates");
+
+    static const int SIZE = (spreadBits(W - 1) | spreadBits(H - 1) << 1) + 1;
+
+    static int index(int u, int v) { return spread(u) | spread(v) << 1; }
+
+    static uint32_t spread(uint32_t x)
+    {
+        x = (x | (x << 4)) & 0x0F0F;
+        x = (x | (x << 2)) & 0x3333;
+        return (x | (x << 1)) & 0x5555;
+    }
+};
+
+// 8 bit grayscale texture, as written by AssetCompiler, row major unless
+// Layout says otherwise. minMax is the optional pyramid from AssetCompiler
+// --minmax: the darkest and the lightest texel of each 2x2 block, then of each
+// 4x4 block and so on, every level row major with min and max side by side,
+// whatever the layout of the texels. A texture that is a mip chain atlas has
+// mips set, and the rasterizer moves the texture coordinates of each triangle
+// onto the level it should sample; only row major textures can be.
+template <int W, int H, int Layout = SPIRAL_LAYOUT_ROWS>
+struct GrayTexture
+{
+    static const int WIDTH = W;
+    static const int HEIGHT = H;
+
+    TextureData pixels;
+    TextureData minMax;
+    const MipChain *mips;
+
+    uint8_t texel(int u, int v) const
+    {
+        const uint8_t *p = pixels + TexelLayout<Layout, W, H>::index(u, v);
+
+        RENDER_FETCH(p);
+        return pgm_read_byte(p);
+    }
+
+    // Bounds of the texels between (u0, v0) and (u1, v1), inclusive, from the
+    // level whose blocks are at least as large as the rectangle, which it
+    // overlaps at most 2x2 of. Returns false without a pyramid.
+    bool range(int u0, int v0, int u1, int v1, uint8_t& low, uint8_t& high) const
+    {
+        if (!minMax)
+            return false;
+
+        if (u0 > u1) { int t = u0; u0 = u1; u1 = t; }
+        if (v0 > v1) { int t = v0; v0 = v1; v1 = t; }
+
+        int extent = u1 - u0 > v1 - v0 ? u1 - u0 : v1 - v0;
+        int level = 1, width = (W + 1) / 2, height = (H + 1) / 2;
+        const uint8_t *blocks = minMax;
+
+        for (; (1 << level) <= extent; level++)
+        {
+            blocks += width * height * 2;
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+        }
+
+        low = 255;
+        high = 0;
+
+        for (int y = v0 >> level; y <= v1 >> level; y++)
+        {
+            for (int x = u0 >> level; x <= u1 >> level; x++)
+            {
+                const uint8_t *block = blocks + (y * width + x) * 2;
+
+                RENDER_FETCH(block);
+                uint8_t blockLow = pgm_read_byte(block);
+                uint8_t blockHigh = pgm_read_byte(block + 1);
+
+                if (blockLow < low)
+                    low = blockLow;
+                if (blockHigh > high)
+                    high = blockHigh;
+            }
+        }
+
+        return true;
+    }
+};
+
+// 4 bit palettized texture, as written by AssetCompiler --palette4: 16 gray
+// levels, then the rows, two texels per byte, the left one in the high
+// nibble. Half the flash of a GrayTexture and half the bytes a span touches,
+// for two reads per texel, one of them from the 16 byte palette.
+template <int W, int H>
+struct PaletteTexture
+{
+    static const int WIDTH = W;
+    static const int HEIGHT = H;
+    static const int LEVELS = 16;
+    static const int STRIDE = (W + 1) / 2;
+
+    TextureData data;
+
+    uint8_t texel(int u, int v) const
+    {
+        const uint8_t *p = data + LEVELS + v * STRIDE + u / 2;
+
+        RENDER_FETCH(p);
+        uint8_t pair = pgm_read_byte(p);
+        uint8_t index = (u & 1) ? pair & 15 : pair >> 4;
+
+        RENDER_FETCH(data + index);
+        return pgm_read_byte(data + index);
+    }
+};
+
+// 1 bit texture, rows padded to whole bytes, most significant bit first.
+// Texels read as 0 or 255.
+template <int W, int H>
+struct BitTexture
+{
+    static const int WIDTH = W;
+    static const int HEIGHT = H;
+
+    TextureData pixels;
+
+    uint8_t texel(int u, int v) const
+    {
+        const int byteWidth = (W + 7) / 8;
+        return (pgm_read_byte(pixels + v * byteWidth + u / 8) & (128 >> (u & 7))) ? 255 : 0;
+    }
+};
+
+// The mip chain of a texture, for the ones that can have one.
+template <typename Texture>
+const MipChain *textureMips(const Texture& texture)
+{
+    return nullptr;
+}
+
+template <int W, int H>
+const MipChain *textureMips(const GrayTexture<W, H>& texture)
+{
+    return texture.mips;
+}
+
+typedef GrayTexture<200, 200> Texture200;
+typedef PaletteTexture<200, 200> PaletteTexture200;
@@ -0,0 +1,92 @@
+#include <Arduino.h>
+#include "RenderConfig.h"
+
+#if SPIRAL_TEXTURE_PARTITION
+#include "../include/Textures.h"
+
+#ifdef ESP32
+#include <esp_partition.h>
+#else
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Textures read straight out of flash, from the textures partition that
+// partitions_textures.csv sets aside and include/textures/Textures.pack is
+// written to (tools/AssetCompiler.cpp). esp_partition_mmap() maps it into the
+// data address space through the flash cache, where the app's own .rodata
+// is, so texels are read exactly as fast as linked ones and nothing is
+// copied. Host builds map the pack file itself, from SPIRAL_TEXTURE_PACK or
+// the working directory.
+//
+// The pointers of the packed blobs are defined here, null until setup()
+// calls mapTextures(), and set once. A pack whose header does not match the
+// offsets the firmware was built with would draw garbage, so they stay null
+// and mapTextures() says why.
+
+#define DEFINE_TEXTURE(name, offset) const unsigned char *name;
+TEXTURE_PACK_BLOBS(DEFINE_TEXTURE)
+
+static const char *const TEXTURE_PACK_MAGIC = "SPTX";
+static const unsigned TEXTURE_PARTITION_SUBTYPE = 0x40;
+
+static uint32_t headerWord(const unsigned char *pack, int i)
+{
+    return pack[i * 4] | pack[i * 4 + 1] << 8 | pack[i * 4 + 2] << 16 | (uint32_t)pack[i * 4 + 3] << 24;
+}
+
+const char *mapTextures()
+{
+    static const unsigned char *pack = NULL;
+
+    if (pack)
+        return NULL;
+
+    const void *mapped = NULL;
+
+#ifdef ESP32
+    const esp_partition_t *partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)TEXTURE_PARTITION_SUBTYPE, "textures");
+    spi_flash_mmap_handle_t handle;
+
+    if (partition == NULL || partition->size < TEXTURE_PACK_SIZE)
+        return "textures: no textures partition large enough for the pack";
+    if (esp_partition_mmap(partition, 0, TEXTURE_PACK_SIZE, SPI_FLASH_MMAP_DATA, &mapped, &handle) != ESP_OK)
+        return "textures: unable to map the textures partition";
+#else
+    const char *path = getenv("SPIRAL_TEXTURE_PACK");
+    int file = open(path ? path : "include/textures/Textures.pack", O_RDONLY);
+    struct stat status;
+
+    if (file >= 0 && (fstat(file, &status) != 0 || status.st_size < (off_t)TEXTURE_PACK_SIZE))
+    {
+        close(file);
+        file = -1;
+    }
+
+    if (file < 0)
+        return "textures: unable to open include/textures/Textures.pack";
+
+    mapped = mmap(NULL, TEXTURE_PACK_SIZE, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+
+    if (mapped == MAP_FAILED)
+        return "textures: unable to map include/textures/Textures.pack";
+#endif
+
+    const unsigned char *bytes = (const unsigned char *)mapped;
+
+    if (memcmp(bytes, TEXTURE_PACK_MAGIC, 4) != 0 || headerWord(bytes, 1) != TEXTURE_PACK_LAYOUT ||
+        headerWord(bytes, 2) != TEXTURE_PACK_SIZE)
+        return "textures: the texture pack does not match the firmware, flash it again";
+
+#define POINT_TEXTURE(name, offset) name = bytes + offset;
+    TEXTURE_PACK_BLOBS(POINT_TEXTURE)
+
+    pack = bytes;
+    return NULL;
+}
+#endif
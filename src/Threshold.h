@@ -0,0 +1,167 @@
+#pragma once
+
+#include <Arduino.h>
+#include "RenderConfig.h"
+#include "Simd.h"
+
+// Blue noise threshold over runs of contiguous 8 bit intensities, packed into
+// frame buffer bytes: a pixel is white where its intensity is above its noise
+// value, exactly as DitherShader decides it. The ESP32 compares four bytes
+// per 32 bit word and the ESP32-S3 16 per PIE vector (SPIRAL_KERNEL); x86
+// builds compare 16 or 32 at a time with SSE2 or AVX2 when the CPU has them.
+
+// High bit of each byte set where a is above b, unsigned. Subtracts with the
+// high bits forced so that no borrow crosses into the next byte.
+inline uint32_t bytesAbove(uint32_t a, uint32_t b)
+{
+    const uint32_t HIGH = 0x80808080;
+    uint32_t difference = ((b | HIGH) - (a & ~HIGH)) ^ ((b ^ ~a) & HIGH);
+    return ((~b & a) | (~(b ^ a) & difference)) & HIGH;
+}
+
+// Four comparison results in memory order, first pixel in bit 3. The
+// multiply moves the high bit of byte k to bit 27 - k without carries.
+inline uint8_t packBytesAbove(uint32_t above)
+{
+    return ((above >> 7) * 0x08040201u) >> 24;
+}
+
+// 8 pixels held in two words each, first pixel in the lowest byte, into one
+// frame buffer byte, leftmost in the most significant bit.
+inline uint8_t thresholdWords(uint32_t i0, uint32_t i1, uint32_t n0, uint32_t n1)
+{
+    return packBytesAbove(bytesAbove(i0, n0)) << 4 | packBytesAbove(bytesAbove(i1, n1));
+}
+
+// Words are read little endian, as on both the ESP32 and x86.
+inline uint8_t thresholdByte(const uint8_t *intensity, const uint8_t *noise)
+{
+    uint32_t i0, i1, n0, n1;
+    memcpy(&i0, intensity, 4);
+    memcpy(&i1, intensity + 4, 4);
+    memcpy(&n0, noise, 4);
+    memcpy(&n1, noise + 4, 4);
+
+    return thresholdWords(i0, i1, n0, n1);
+}
+
+// 8 bytes of 0xFF or 0 from a vector compare, into one frame buffer byte.
+inline uint8_t packAboveBytes(const uint8_t *above)
+{
+    const uint32_t HIGH = 0x80808080;
+    uint32_t a0, a1;
+    memcpy(&a0, above, 4);
+    memcpy(&a1, above + 4, 4);
+
+    return packBytesAbove(a0 & HIGH) << 4 | packBytesAbove(a1 & HIGH);
+}
+
+// Thresholds count * 8 pixels into count frame buffer bytes. Pixels whose bit
+// is set in keep are left as bytes already has them.
+//
+// The reference, one pixel at a time.
+inline void thresholdBytesScalar(const uint8_t *intensity, const uint8_t *noise, const uint8_t *keep,
+                                 uint8_t *bytes, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        uint8_t bits = 0;
+
+        for (int k = 0; k < 8; k++)
+            if (intensity[i * 8 + k] > noise[i * 8 + k])
+                bits |= 0x80 >> k;
+
+        bytes[i] = (bytes[i] & keep[i]) | (bits & ~keep[i]);
+    }
+}
+
+inline void thresholdBytesSwar(const uint8_t *intensity, const uint8_t *noise, const uint8_t *keep,
+                                   uint8_t *bytes, int count)
+{
+    for (int i = 0; i < count; i++)
+        bytes[i] = (bytes[i] & keep[i]) | (thresholdByte(intensity + i * 8, noise + i * 8) & ~keep[i]);
+}
+
+#if SPIRAL_KERNEL == SPIRAL_KERNEL_PIE
+inline void thresholdBytesPie(const uint8_t *intensity, const uint8_t *noise, const uint8_t *keep, uint8_t *bytes,
+                              int count)
+{
+    alignas(16) uint8_t above[16];
+    int i = 0;
+
+    for (; i + 2 <= count; i += 2)
+    {
+        bytesAbove16(intensity + i * 8, noise + i * 8, above);
+
+        for (int k = 0; k < 2; k++)
+            bytes[i + k] = (bytes[i + k] & keep[i + k]) | (packAboveBytes(above + k * 8) & ~keep[i + k]);
+    }
+
+    thresholdBytesSwar(intensity + i * 8, noise + i * 8, keep + i, bytes + i, count - i);
+}
+#endif
+
+#if SPIRAL_X86_SIMD
+// Signed compares after flipping the high bits are unsigned compares.
+SIMD_TARGET_SSE2 inline void thresholdBytesSse2(const uint8_t *intensity, const uint8_t *noise, const uint8_t *keep,
+                                                uint8_t *bytes, int count)
+{
+    const __m128i bias = _mm_set1_epi8((char)0x80);
+    int i = 0;
+
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(intensity + i * 8)), bias);
+        __m128i n = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(noise + i * 8)), bias);
+        uint32_t m = reverseBitsInBytes(_mm_movemask_epi8(_mm_cmpgt_epi8(a, n)));
+
+        for (int k = 0; k < 2; k++)
+            bytes[i + k] = (bytes[i + k] & keep[i + k]) | ((m >> (k * 8)) & ~keep[i + k]);
+    }
+
+    thresholdBytesSwar(intensity + i * 8, noise + i * 8, keep + i, bytes + i, count - i);
+}
+
+SIMD_TARGET_AVX2 inline void thresholdBytesAvx2(const uint8_t *intensity, const uint8_t *noise, const uint8_t *keep,
+                                                uint8_t *bytes, int count)
+{
+    const __m256i bias = _mm256_set1_epi8((char)0x80);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256i a = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(intensity + i * 8)), bias);
+        __m256i n = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(noise + i * 8)), bias);
+        uint32_t m = reverseBitsInBytes(_mm256_movemask_epi8(_mm256_cmpgt_epi8(a, n)));
+
+        for (int k = 0; k < 4; k++)
+            bytes[i + k] = (bytes[i + k] & keep[i + k]) | ((m >> (k * 8)) & ~keep[i + k]);
+    }
+
+    thresholdBytesSwar(intensity + i * 8, noise + i * 8, keep + i, bytes + i, count - i);
+}
+#endif
+
+inline void thresholdBytes(const uint8_t *intensity, const uint8_t *noise, const uint8_t *keep, uint8_t *bytes,
+                           int count)
+{
+#if SPIRAL_KERNEL == SPIRAL_KERNEL_SCALAR
+    thresholdBytesScalar(intensity, noise, keep, bytes, count);
+#elif SPIRAL_KERNEL == SPIRAL_KERNEL_PIE
+    thresholdBytesPie(intensity, noise, keep, bytes, count);
+#else
+#if SPIRAL_X86_SIMD
+    switch (simdLevel())
+    {
+    case SPIRAL_SIMD_AVX2:
+        thresholdBytesAvx2(intensity, noise, keep, bytes, count);
+        return;
+    case SPIRAL_SIMD_SSE2:
+        thresholdBytesSse2(intensity, noise, keep, bytes, count);
+        return;
+    }
+#endif
+
+    thresholdBytesSwar(intensity, noise, keep, bytes, count);
+#endif
+}
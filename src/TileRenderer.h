@@ -0,0 +1,251 @@
+#pragma once
+
+#include <Watchy.h>
+#include "RenderConfig.h"
+#include "RenderStats.h"
+#include "Rasterizer.h"
+#include "RenderTarget.h"
+#include "PrimitiveList.h"
+
+// Deferred renderer: records the frame, sorts the primitives into 8x8 pixel
+// tiles and then draws the screen one tile at a time into a frame buffer. Each
+// tile row is exactly one frame buffer byte and a tile only reads 64 bytes of
+// the noise mask, so the working set of a tile stays tiny. Blocks a triangle
+// covers completely are filled without any edge tests.
+struct TileRenderer
+{
+    static const int TILE_SIZE = 8;
+    static const int TILES_X = SCREEN_WIDTH / TILE_SIZE;
+    static const int TILES_Y = SCREEN_HEIGHT / TILE_SIZE;
+    static const int TILE_COUNT = TILES_X * TILES_Y;
+
+    // A frame that records more than this is drawn in several passes.
+    static const int MAX_PRIMITIVES = 384;
+    static const int MAX_TILE_ENTRIES = 8192;
+
+    FrameBuffer frame;
+    PrimitiveList<MAX_PRIMITIVES> primitives;
+    int entryCount = 0;
+
+    // Set up for every recorded triangle when the frame is drawn.
+    EdgeFunction edges[MAX_PRIMITIVES][3];
+
+    // Primitive indices sorted by tile, in drawing order within each tile.
+    uint16_t tileStart[TILE_COUNT + 1];
+    uint16_t entries[MAX_TILE_ENTRIES];
+
+    void startWrite() {}
+    void endWrite() {}
+
+    // Clearing the screen makes everything recorded so far invisible.
+    void fill(uint16_t color)
+    {
+        primitives.clear();
+        entryCount = 0;
+        frame.fill(color);
+    }
+
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+        reserve();
+
+        if (primitives.addLine(x0, y0, x1, y1, color))
+            entryCount += tileCount(primitives[primitives.count - 1]);
+    }
+
+    template <typename Shader>
+    void addTriangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2, const Shader& shader)
+    {
+        reserve();
+
+        if (primitives.addTriangle(v0, v1, v2, shader))
+            entryCount += tileCount(primitives[primitives.count - 1]);
+    }
+
+    void present()
+    {
+        flush();
+        frame.present();
+    }
+
+    // Draws everything recorded so far, tile by tile.
+    void flush()
+    {
+        if (primitives.count == 0)
+            return;
+
+#if SPIRAL_BENCHMARK && SPIRAL_OVERDRAW
+        uint8_t recordingMesh = renderStats.mesh;
+#endif
+
+        // Counting sort of the tile entries. Filling the buckets back to front
+        // keeps the primitives of each tile in drawing order.
+        memset(tileStart, 0, sizeof(tileStart));
+
+        for (int i = 0; i < primitives.count; i++)
+        {
+            const Primitive &p = primitives[i];
+            for (int ty = p.y0 / TILE_SIZE; ty <= p.y1 / TILE_SIZE; ty++)
+                for (int tx = p.x0 / TILE_SIZE; tx <= p.x1 / TILE_SIZE; tx++)
+                    tileStart[ty * TILES_X + tx]++;
+
+            if (!p.isLine)
+                setupEdgeFunctions(p.triangle.v0, p.triangle.v1, p.triangle.v2, edges[i]);
+        }
+
+        for (int t = 1; t <= TILE_COUNT; t++)
+            tileStart[t] += tileStart[t - 1];
+
+        for (int i = primitives.count - 1; i >= 0; i--)
+        {
+            const Primitive &p = primitives[i];
+            for (int ty = p.y0 / TILE_SIZE; ty <= p.y1 / TILE_SIZE; ty++)
+                for (int tx = p.x0 / TILE_SIZE; tx <= p.x1 / TILE_SIZE; tx++)
+                    entries[--tileStart[ty * TILES_X + tx]] = i;
+        }
+
+        for (int ty = 0; ty < TILES_Y; ty++)
+        {
+            for (int tx = 0; tx < TILES_X; tx++)
+            {
+                int t = ty * TILES_X + tx;
+
+                int x0 = tx * TILE_SIZE, y0 = ty * TILE_SIZE;
+
+                for (int e = tileStart[t]; e < tileStart[t + 1]; e++)
+                {
+                    const Primitive &p = primitives[entries[e]];
+#if SPIRAL_BENCHMARK && SPIRAL_OVERDRAW
+                    RENDER_MESH(p.mesh);
+#endif
+
+                    if (p.isLine)
+                        p.line.draw(frame, x0, y0, x0 + TILE_SIZE - 1, y0 + TILE_SIZE - 1);
+                    else
+                        drawTriangleInTile(p.triangle, edges[entries[e]], x0, y0);
+                }
+            }
+        }
+
+        primitives.clear();
+        entryCount = 0;
+
+#if SPIRAL_BENCHMARK && SPIRAL_OVERDRAW
+        RENDER_MESH(recordingMesh);
+#endif
+    }
+
+private:
+    static int tileCount(const Primitive& p)
+    {
+        return (p.x1 / TILE_SIZE - p.x0 / TILE_SIZE + 1) * (p.y1 / TILE_SIZE - p.y0 / TILE_SIZE + 1);
+    }
+
+    // Draws what is already recorded when the next primitive might not fit.
+    void reserve()
+    {
+        if (primitives.full() || entryCount + TILE_COUNT > MAX_TILE_ENTRIES)
+        {
+            RENDER_STAT(tileFlushes, 1);
+            flush();
+        }
+    }
+
+    void drawTriangleInTile(const RecordedTriangle& triangle, const EdgeFunction *edges, int x0, int y0)
+    {
+        const UvGradients &gradients = triangle.gradients;
+        const int last = TILE_SIZE - 1;
+
+        // Classify the block by the edge values at its corners.
+        bool full = true;
+
+        for (int i = 0; i < 3; i++)
+        {
+            int32_t corner = edges[i].at(x0, y0);
+            int32_t high = corner + (edges[i].stepX > 0 ? last * edges[i].stepX : 0) +
+                           (edges[i].stepY > 0 ? last * edges[i].stepY : 0);
+            int32_t low = corner + (edges[i].stepX < 0 ? last * edges[i].stepX : 0) +
+                          (edges[i].stepY < 0 ? last * edges[i].stepY : 0);
+
+            if (high < 0)
+            {
+                RENDER_STAT(tileBlocksEmpty, 1);
+                return;
+            }
+
+            if (low < 0)
+                full = false;
+        }
+
+        int32_t u, v;
+
+        if (full)
+        {
+            RENDER_STAT(tileBlocksFull, 1);
+
+            for (int y = y0; y < y0 + TILE_SIZE; y++)
+            {
+                RENDER_STAT(shadedPixels, TILE_SIZE);
+                RENDER_OVERDRAW(x0, y, TILE_SIZE);
+                gradients.evaluate(x0, y, u, v);
+                triangle.shade(frame, x0, y, TILE_SIZE, u, v, gradients.dudx, gradients.dvdx, triangle.shader);
+            }
+
+            return;
+        }
+
+        RENDER_STAT(tileBlocksPartial, 1);
+
+        int32_t e0 = edges[0].at(x0, y0), e1 = edges[1].at(x0, y0), e2 = edges[2].at(x0, y0);
+
+        for (int y = y0; y < y0 + TILE_SIZE; y++)
+        {
+            // The inside of a triangle is convex, so the covered pixels of a
+            // row form one run.
+            int start = TILE_SIZE, end = 0;
+            int32_t a = e0, b = e1, c = e2;
+
+            for (int x = 0; x < TILE_SIZE; x++)
+            {
+                if ((a | b | c) >= 0)
+                {
+                    if (start == TILE_SIZE)
+                        start = x;
+                    end = x + 1;
+                }
+
+                a += edges[0].stepX;
+                b += edges[1].stepX;
+                c += edges[2].stepX;
+            }
+
+            if (start < end)
+            {
+                RENDER_STAT(shadedPixels, end - start);
+                RENDER_OVERDRAW(x0 + start, y, end - start);
+                gradients.evaluate(x0 + start, y, u, v);
+                triangle.shade(frame, x0 + start, y, end - start, u, v, gradients.dudx, gradients.dvdx,
+                               triangle.shader);
+            }
+
+            e0 += edges[0].stepY;
+            e1 += edges[1].stepY;
+            e2 += edges[2].stepY;
+        }
+    }
+};
+
+// Triangles sent to a TileRenderer are recorded instead of scanned. Found by
+// argument dependent lookup from rasterizeTriangle().
+template <typename Shader>
+void scanTriangle(TileRenderer& target, RasterVertex v0, RasterVertex v1, RasterVertex v2, const Shader& shader)
+{
+    target.addTriangle(v0, v1, v2, shader);
+}
+
+// Strip triangles too. Edges are set up when the frame is drawn.
+template <typename Shader>
+void scanStripTriangle(TileRenderer& target, StripEdges& edges, const RasterVertex* v, const Shader& shader)
+{
+    target.addTriangle(v[0], v[1], v[2], shader);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Fixed.h"
+
+template <typename T>
+struct Vec2
+{
+    T x;
+    T y;
+
+public:
+    static T dotProduct(const Vec2& v1, const Vec2& v2)
+    {
+        return v1.x * v2.x + v1.y * v2.y;
+    }
+
+    static T crossProduct(const Vec2& v1, const Vec2& v2)
+    {
+        return v1.x * v2.y - v1.y * v2.x;
+    }
+
+    static Vec2 rotateVectorByRightAngle(const Vec2& vector, const int& angle)
+    {
+        int tempAngle = angle % 4;
+
+        switch (tempAngle)
+        {
+            case 1:
+            return {-vector.y, vector.x};
+            case 2:
+            return {-vector.x, -vector.y};
+            case 3:
+            return {vector.y, -vector.x};
+            default:
+            return vector;
+        }
+    }
+
+    static Vec2 rotateVector(const Vec2& vector, const T& angle)
+    {
+        T radians = angle * T(DEG_TO_RAD);
+        T sinAngle = scalarSin(radians);
+        T cosAngle = scalarCos(radians);
+
+        return rotateVector(vector, sinAngle, cosAngle);
+    }
+
+    static Vec2 rotateVector(const Vec2& vector, const T& sinAngle, const T& cosAngle)
+    {
+        Vec2 newVector;
+        newVector.x = cosAngle * vector.x - sinAngle * vector.y;
+        newVector.y = sinAngle * vector.x + cosAngle * vector.y;
+        return newVector;
+    }
+
+    void normalize()
+    {
+        T magnitude = scalarSqrt(x * x + y * y);
+
+        if (magnitude <= T(0))
+            return;
+
+        x /= magnitude;
+        y /= magnitude;
+    }
+
+    void scale(const T& scale)
+    {
+        x *= scale;
+        y *= scale;
+    }
+
+    Vec2 operator+(const Vec2& a) const
+    {
+        return {x + a.x, y + a.y};
+    }
+
+    Vec2 operator-(const Vec2& a) const
+    {
+        return {x - a.x, y - a.y};
+    }
+
+    Vec2 operator*(const T scale) const
+    {
+        return {x * scale, y * scale};
+    }
+
+    template <typename U>
+    operator Vec2<U>() const { return {static_cast<U>(x), static_cast<U>(y)}; }
+};
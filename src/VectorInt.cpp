@@ -1 +0,0 @@
-#include "VectorInt.h"
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <Watchy.h>
+#include "RenderConfig.h"
+#include "RenderStats.h"
+#include "Rasterizer.h"
+#include "RenderTarget.h"
+#include "PrimitiveList.h"
+#include "Shaders.h"
+
+// Two pass renderer. Pass one scans everything as soon as it is drawn, like
+// immediate mode, but dithered textures only leave a material ID and the
+// texel index in the pixels they cover. Pass two, at present(), fetches each
+// texel still visible once and thresholds it against the blue noise mask.
+// However much the triangles overlap, every pixel costs at most one texture
+// fetch.
+//
+// Pixels other shaders and the outlines write are final in pass one: they go
+// straight into the frame buffer and clear the pixel's material ID, so
+// alpha tested shaders like MaskedColorShader still decide coverage as they
+// are drawn.
+//
+// The IDs and texel indices, about 90 KB, come from the heap when the
+// renderer is created instead of taking up static DRAM next to the rest of
+// the app. Without them every span is shaded as it is drawn, like immediate
+// mode, and the image is the same.
+struct VisibilityBuffer
+{
+    // Material IDs take 2 bits per pixel, 0 being a pixel the frame buffer
+    // already holds.
+    static const int MAX_MATERIALS = 3;
+    static const int ID_STRIDE = SCREEN_WIDTH / 4;
+
+    // Dithered GrayTexture, resolved by reading texel index bytes past pixels.
+    struct Material
+    {
+        const uint8_t *pixels;
+    };
+
+    FrameBuffer frame;
+    uint8_t *ids;
+    uint16_t *texels;
+    Material materials[MAX_MATERIALS];
+    int materialCount = 0;
+
+    VisibilityBuffer()
+        : ids((uint8_t *)malloc(ID_STRIDE * SCREEN_HEIGHT)),
+          texels((uint16_t *)malloc(SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint16_t)))
+    {
+        if (!ids || !texels)
+        {
+            free(ids);
+            free(texels);
+            ids = NULL;
+            texels = NULL;
+        }
+    }
+
+    ~VisibilityBuffer()
+    {
+        free(ids);
+        free(texels);
+    }
+
+    VisibilityBuffer(const VisibilityBuffer&) = delete;
+    VisibilityBuffer& operator=(const VisibilityBuffer&) = delete;
+
+    // Whether the buffers were allocated, and texturing is deferred.
+    bool deferred() const { return ids != NULL; }
+
+    void startWrite() {}
+    void endWrite() {}
+
+    void fill(uint16_t color)
+    {
+        frame.fill(color);
+        materialCount = 0;
+
+        if (ids)
+            memset(ids, 0, ID_STRIDE * SCREEN_HEIGHT);
+    }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color)
+    {
+        if (x < 0 || x >= SCREEN_WIDTH || y < 0 || y >= SCREEN_HEIGHT)
+            return;
+
+        frame.drawPixel(x, y, color);
+
+        if (ids)
+            storeIds(ids + y * ID_STRIDE + (x >> 2), 0, idMask(x, x + 1));
+    }
+
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+        RasterLine line;
+        line.init(x0, y0, x1, y1, color);
+        line.draw(*this, 0, 0, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1);
+    }
+
+    // Any other shader runs now, as the frame buffer would run it.
+    template <typename Shader>
+    void shadeSpan(int x, int y, int w, int32_t u, int32_t v, int32_t dudx, int32_t dvdx, const Shader& shader)
+    {
+        for (int end = x + w; x < end; x++)
+        {
+            uint16_t color;
+
+            RENDER_SHADED(x, y);
+
+            if (shader(x, y, u >> Fixed::FRACTION_BITS, v >> Fixed::FRACTION_BITS, color))
+                drawPixel(x, y, color);
+
+            u += dudx;
+            v += dvdx;
+        }
+    }
+
+    // Pass one for dithered textures: the material ID for the whole span and
+    // a texel index per pixel, in the texture's layout.
+    template <int W, int H, int Layout>
+    void shadeSpan(int x, int y, int w, int32_t u, int32_t v, int32_t dudx, int32_t dvdx,
+                   const DitherShader<GrayTexture<W, H, Layout> >& shader)
+    {
+        static_assert(TexelLayout<Layout, W, H>::SIZE <= 65536, "texel indices are 16 bit");
+
+        int id = materialId(shader.texture.pixels);
+
+        if (id == 0)
+        {
+            shadeSpan<DitherShader<GrayTexture<W, H, Layout> > >(x, y, w, u, v, dudx, dvdx, shader);
+            return;
+        }
+
+        int end = x + w;
+        uint16_t *texel = texels + y * SCREEN_WIDTH + x;
+
+        for (int i = 0; i < w; i++)
+        {
+            texel[i] = TexelLayout<Layout, W, H>::index(u >> Fixed::FRACTION_BITS, v >> Fixed::FRACTION_BITS);
+            u += dudx;
+            v += dvdx;
+        }
+
+        // Every 2 bit field of pattern holds the ID.
+        uint8_t pattern = id * 0x55;
+        uint8_t *row = ids + y * ID_STRIDE;
+
+        for (int start = x; start < end;)
+        {
+            int byteEnd = (start | 3) + 1;
+            if (byteEnd > end)
+                byteEnd = end;
+
+            storeIds(row + (start >> 2), pattern, idMask(start, byteEnd));
+            start = byteEnd;
+        }
+    }
+
+    void present()
+    {
+        resolve();
+        frame.present();
+    }
+
+    // Pass two: one texture fetch per pixel that still has a material.
+    void resolve()
+    {
+        if (!ids)
+            return;
+
+        for (int y = 0; y < SCREEN_HEIGHT; y++)
+        {
+            const uint8_t *idRow = ids + y * ID_STRIDE;
+            const uint16_t *texelRow = texels + y * SCREEN_WIDTH;
+            const uint8_t *noiseRow = BlueNoise200 + y * SCREEN_WIDTH;
+            uint8_t *row = frame.bytes + y * FrameBuffer::STRIDE;
+
+            // Each frame buffer byte spans two ID bytes.
+            for (int b = 0; b < FrameBuffer::STRIDE; b++)
+            {
+                uint16_t pixelIds = idRow[b * 2] << 8 | idRow[b * 2 + 1];
+
+                if (pixelIds == 0)
+                    continue;
+
+                uint8_t bits = 0, mask = 0;
+
+                for (int i = 0; i < 8; i++, pixelIds <<= 2)
+                {
+                    int id = pixelIds >> 14 & 3;
+                    if (id == 0)
+                        continue;
+
+                    int x = b * 8 + i;
+                    uint8_t bit = 0x80 >> i;
+
+                    RENDER_SHADED(x, y);
+
+                    mask |= bit;
+                    if (pgm_read_byte(materials[id - 1].pixels + texelRow[x]) > noiseRow[x])
+                        bits |= bit;
+                }
+
+                RENDER_STAT(resolvedPixels, __builtin_popcount(mask));
+                FrameBuffer::store(row + b, bits, mask);
+            }
+        }
+    }
+
+private:
+    // Returns 0 once every ID is taken, or without buffers, and the span is
+    // shaded right away.
+    int materialId(const uint8_t *pixels)
+    {
+        if (!ids)
+            return 0;
+
+        for (int i = 0; i < materialCount; i++)
+            if (materials[i].pixels == pixels)
+                return i + 1;
+
+        if (materialCount == MAX_MATERIALS)
+            return 0;
+
+        materials[materialCount].pixels = pixels;
+        return ++materialCount;
+    }
+
+    // Fields of pixels [x, end) within one ID byte, leftmost pixel in the
+    // most significant bits.
+    static uint8_t idMask(int x, int end)
+    {
+        return (0xFF >> ((x & 3) * 2)) & ~(0xFF >> ((((end - 1) & 3) + 1) * 2));
+    }
+
+    static void storeIds(uint8_t *p, uint8_t fields, uint8_t mask)
+    {
+        *p = (*p & ~mask) | (fields & mask);
+    }
+};
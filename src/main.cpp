@@ -6,6 +6,18 @@
 SpiralWatchy watchy(settings);
 
 void setup() {
+#if SPIRAL_TEXTURE_PARTITION
+  // Without the textures partition the face stays blank, but the watch still
+  // has to go through init() to deep sleep and wake for the next minute.
+  if (const char *error = mapTextures()) {
+    Serial.begin(115200);
+    Serial.println(error);
+  }
+#endif
+#if SPIRAL_BENCHMARK
+  Serial.begin(115200);
+  watchy.benchmarkWatchFace();
+#endif
   watchy.init();
 }
 
@@ -0,0 +1,14 @@
+// Runs the boot benchmark of SPIRAL_BENCHMARK builds on the host and prints
+// its report: frame time, shaded pixels per second and whatever counters the
+// configuration has. Timings depend on the host; the counters do not. Fails
+// when the dither kernels do not produce the same bytes as the shader.
+
+#include "SpiralWatchy.h"
+
+int main()
+{
+    watchySettings settings = {};
+    SpiralWatchy watchy(settings);
+
+    return watchy.benchmarkWatchFace() ? 0 : 1;
+}
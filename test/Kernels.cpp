@@ -0,0 +1,186 @@
+// Checks the dither kernels bit for bit against the pixel by pixel
+// references at every vector level the build and the CPU have:
+// thresholdBytes() against thresholdBytesScalar() on random intensities,
+// noise and keep masks, and shadeBytes() against DitherShader on random
+// spans of the face texture. Lengths and alignments vary, so both the vector
+// loops and the tails they leave run. Before that, the byte compares the
+// kernels are built from are checked on every pair of byte values.
+
+#include <random>
+#include "Shaders.h"
+
+static const char *const SIMD_NAMES[] = {"scalar", "SSE2", "AVX2"};
+static const int CASES = 20000;
+static const int MAX_BYTES = SCREEN_WIDTH / 8;
+static const int MAX_REPORTED = 10;
+
+static const DitherShader<Texture200> FACE_SHADER = {{SpiralFaceWithShadow}};
+
+static std::mt19937 generator(1);
+
+static int uniform(int low, int high)
+{
+    return std::uniform_int_distribution<int>(low, high)(generator);
+}
+
+// bytesAbove() with each pair in each lane of the word, the other lanes
+// random, and with SPIRAL_KERNEL_PIE bytesAbove16() at every alignment.
+static int checkCompares()
+{
+    int different = 0;
+
+    for (int a = 0; a < 256; a++)
+    {
+        for (int b = 0; b < 256; b++)
+        {
+            for (int lane = 0; lane < 4; lane++)
+            {
+                uint8_t left[4], right[4];
+                uint32_t expected = 0, x, y;
+
+                for (int k = 0; k < 4; k++)
+                {
+                    left[k] = k == lane ? a : uniform(0, 255);
+                    right[k] = k == lane ? b : uniform(0, 255);
+                    if (left[k] > right[k])
+                        expected |= 0x80u << (k * 8);
+                }
+
+                memcpy(&x, left, 4);
+                memcpy(&y, right, 4);
+
+                if (bytesAbove(x, y) != expected && different++ < MAX_REPORTED)
+                    printf("bytesAbove() of %d and %d in lane %d differs\n", a, b, lane);
+            }
+        }
+    }
+
+#if SPIRAL_KERNEL == SPIRAL_KERNEL_PIE
+    // All 65536 pairs 16 at a time, from each offset into a 16 byte block.
+    alignas(16) uint8_t left[32], right[32], above[16];
+
+    for (int offset = 0; offset < 16; offset++)
+    {
+        for (int pair = 0; pair < 65536; pair += 16)
+        {
+            for (int k = 0; k < 16; k++)
+            {
+                left[offset + k] = (pair + k) >> 8;
+                right[offset + k] = pair + k;
+            }
+
+            bytesAbove16(left + offset, right + offset, above);
+
+            for (int k = 0; k < 16; k++)
+                if (above[k] != (left[offset + k] > right[offset + k] ? 0xFF : 0) && different++ < MAX_REPORTED)
+                    printf("bytesAbove16() of %d and %d at offset %d differs\n", left[offset + k],
+                           right[offset + k], offset);
+        }
+    }
+#endif
+
+    return different;
+}
+
+static int checkThreshold(const char *level)
+{
+    uint8_t intensity[MAX_BYTES * 8 + 32], noise[MAX_BYTES * 8 + 32];
+    uint8_t keep[MAX_BYTES], expected[MAX_BYTES], bytes[MAX_BYTES];
+    int different = 0;
+
+    for (int c = 0; c < CASES; c++)
+    {
+        int count = uniform(0, MAX_BYTES);
+        uint8_t *in = intensity + uniform(0, 31), *n = noise + uniform(0, 31);
+
+        // Every eighth pixel equal to its noise value, which stays black.
+        for (int i = 0; i < count * 8; i++)
+        {
+            n[i] = uniform(0, 255);
+            in[i] = uniform(0, 7) ? uniform(0, 255) : n[i];
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            keep[i] = uniform(0, 3) ? 0 : uniform(0, 255);
+            expected[i] = bytes[i] = uniform(0, 255);
+        }
+
+        thresholdBytesScalar(in, n, keep, expected, count);
+        thresholdBytes(in, n, keep, bytes, count);
+
+        if (memcmp(expected, bytes, count) != 0 && different++ < MAX_REPORTED)
+            printf("%s: thresholdBytes() of %d bytes differs\n", level, count);
+    }
+
+    return different;
+}
+
+static int checkShade(const char *level, int& vectorBytes)
+{
+    uint8_t out[MAX_BYTES];
+    int different = 0;
+
+    for (int c = 0; c < CASES; c++)
+    {
+        int count = uniform(1, MAX_BYTES);
+        int x = uniform(0, MAX_BYTES - count) * 8, y = uniform(0, SCREEN_HEIGHT - 1);
+
+        // Both ends inside the texture, so every texel in between is too.
+        int32_t u = uniform(0, 200 * Fixed::ONE - 1), v = uniform(0, 200 * Fixed::ONE - 1);
+        int32_t dudx = (uniform(0, 200 * Fixed::ONE - 1) - u) / (count * 8);
+        int32_t dvdx = (uniform(0, 200 * Fixed::ONE - 1) - v) / (count * 8);
+
+        int done = shadeBytes(FACE_SHADER, x, y, u, v, dudx, dvdx, out, count);
+        vectorBytes += done;
+
+        for (int b = 0; b < done; b++)
+        {
+            uint8_t bits = 0;
+
+            for (int k = 0; k < 8; k++)
+            {
+                int i = b * 8 + k;
+                uint16_t color;
+                FACE_SHADER(x + i, y, (u + i * dudx) >> Fixed::FRACTION_BITS, (v + i * dvdx) >> Fixed::FRACTION_BITS,
+                            color);
+                if (color)
+                    bits |= 0x80 >> k;
+            }
+
+            if (bits != out[b])
+            {
+                if (different++ < MAX_REPORTED)
+                    printf("%s: shadeBytes() at (%d, %d) differs in byte %d\n", level, x, y, b);
+                break;
+            }
+        }
+    }
+
+    return different;
+}
+
+int main()
+{
+    int failures = checkCompares();
+    printf("byte compares: every pair of byte values, %s\n", failures ? "DIFFERENT" : "identical");
+
+    for (int level = SPIRAL_SIMD_NONE; level <= SPIRAL_SIMD; level++)
+    {
+        if (level > supportedSimdLevel())
+        {
+            printf("%s: not available, skipped\n", SIMD_NAMES[level]);
+            continue;
+        }
+
+        setSimdLevel(level);
+
+        int vectorBytes = 0;
+        int different = checkThreshold(SIMD_NAMES[level]) + checkShade(SIMD_NAMES[level], vectorBytes);
+        printf("%s: %d threshold runs and %d spans, %d bytes shaded by shadeBytes(), %s\n", SIMD_NAMES[level], CASES,
+               CASES, vectorBytes, different ? "DIFFERENT" : "identical");
+        failures += different;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,22 @@
+// Fails if any mesh of the watch face covers a pixel twice in any of the
+// 1440 minutes of the day. The triangles of a mesh tile it without
+// overlapping, so a pixel covered twice lies on an edge that two of them both
+// claimed, which the top-left fill rule rules out. Also prints how many
+// shader runs land on pixels drawn over later, which is up to the drawing
+// order rather than the fill rule.
+
+#include "SpiralWatchy.h"
+
+int main()
+{
+    watchySettings settings = {};
+    SpiralWatchy watchy(settings);
+    SpiralWatchy::OverdrawReport report = watchy.measureOverdraw();
+
+    printf("overdraw over 1440 minutes: %lu pixels, worst frame %lu\n", (unsigned long)report.overdrawnPixels,
+           (unsigned long)report.worstFrame);
+    printf("shader runs per frame: %lu, %lu of them on pixels shaded again\n",
+           (unsigned long)(report.shaderRuns / 1440), (unsigned long)(report.wastedRuns / 1440));
+
+    return report.overdrawnPixels == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+// Renders every minute of the day at three battery levels, 4320 frames, and
+// either writes the frames to a file or compares them byte for byte with the
+// frames a file holds:
+//
+//     RenderFrames <frames>              writes the frames
+//     RenderFrames --compare <frames>    fails on the first frames that differ
+//
+// test/CMakeLists.txt builds it once per configuration and checks the ones
+// that have to draw the same image against the default build.
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include "SpiralWatchy.h"
+
+static const float BATTERY_VOLTAGES[] = {4.2f, 3.8f, 3.5f};
+static const int FRAME_BYTES = sizeof(Watchy::display.buffer);
+static const int MAX_REPORTED = 10;
+
+int main(int argc, char **argv)
+{
+    bool compare = argc == 3 && std::string(argv[1]) == "--compare";
+
+    if (argc != 2 && !compare)
+    {
+        fprintf(stderr, "Usage: %s [--compare] <frames>\n", argv[0]);
+        return 2;
+    }
+
+    const char *path = argv[argc - 1];
+    FILE *file = fopen(path, compare ? "rb" : "wb");
+
+    if (!file)
+    {
+        fprintf(stderr, "Unable to open %s\n", path);
+        return 2;
+    }
+
+#if SPIRAL_TEXTURE_PARTITION
+    if (const char *error = mapTextures())
+    {
+        fprintf(stderr, "%s\n", error);
+        return 2;
+    }
+#endif
+
+    watchySettings settings = {};
+    SpiralWatchy watchy(settings);
+    std::vector<uint8_t> expected(FRAME_BYTES);
+    int frames = 0, different = 0;
+
+    for (float voltage : BATTERY_VOLTAGES)
+    {
+        for (int minute = 0; minute < 24 * 60; minute++, frames++)
+        {
+            watchy.batteryVoltage = voltage;
+            watchy.currentTime.Hour = minute / 60;
+            watchy.currentTime.Minute = minute % 60;
+            watchy.drawWatchFace();
+
+            if (!compare)
+            {
+                fwrite(Watchy::display.buffer, 1, FRAME_BYTES, file);
+                continue;
+            }
+
+            if (fread(expected.data(), 1, FRAME_BYTES, file) != (size_t)FRAME_BYTES)
+            {
+                fprintf(stderr, "%s ends after %d frames\n", path, frames);
+                return 1;
+            }
+
+            if (memcmp(expected.data(), Watchy::display.buffer, FRAME_BYTES) != 0 && different++ < MAX_REPORTED)
+                printf("%02d:%02d at %.1f V differs\n", minute / 60, minute % 60, voltage);
+        }
+    }
+
+    fclose(file);
+
+    if (different)
+    {
+        printf("%d of %d frames differ\n", different, frames);
+        return 1;
+    }
+
+    printf("%d frames %s\n", frames, compare ? "identical" : "written");
+    return 0;
+}
@@ -0,0 +1,198 @@
+// Sends random spans through Sampler with each address mode and checks the
+// texel every pixel ends up reading against the mode applied pixel by pixel:
+// clamp to the edge texel, wrap by whole texture sizes, or leave the pixel
+// alone outside the texture. Half the spans start inside the texture, the
+// others anywhere within a few texture sizes of it. They step up to three
+// texels per pixel either way, and sometimes not at all, for square, power of
+// two and atlas sized textures, and for each level of a mip chain atlas.
+
+#include <random>
+#include "Sampler.h"
+
+static const int CASES = 20000;
+static const int MAX_WIDTH = 64;
+static const int MAX_REPORTED = 10;
+
+static std::mt19937 generator(1);
+
+static int uniform(int low, int high)
+{
+    return std::uniform_int_distribution<int>(low, high)(generator);
+}
+
+template <int W, int H>
+struct SizedTexture
+{
+    static const int WIDTH = W;
+    static const int HEIGHT = H;
+};
+
+struct NoShader
+{
+};
+
+// Keeps the texel each pixel of one row reads, or -1 for pixels no span
+// reached.
+struct RecordingTarget
+{
+    int u[MAX_WIDTH], v[MAX_WIDTH];
+
+    void clear()
+    {
+        for (int i = 0; i < MAX_WIDTH; i++)
+            u[i] = v[i] = -1;
+    }
+
+    void shadeSpan(int x, int y, int w, int32_t su, int32_t sv, int32_t dudx, int32_t dvdx, const NoShader& shader)
+    {
+        for (int i = 0; i < w; i++)
+        {
+            u[x + i] = (su + i * dudx) >> Fixed::FRACTION_BITS;
+            v[x + i] = (sv + i * dvdx) >> Fixed::FRACTION_BITS;
+        }
+    }
+};
+
+// One texture coordinate in whole texels, or -1 where the pixel is skipped.
+static int clampTexel(int64_t c, int size)
+{
+    int t = (int)(c >> Fixed::FRACTION_BITS);
+    return t < 0 ? 0 : t >= size ? size - 1 : t;
+}
+
+static int wrapTexel(int64_t c, int size)
+{
+    int t = (int)(c >> Fixed::FRACTION_BITS) % size;
+    return t < 0 ? t + size : t;
+}
+
+static int borderTexel(int64_t c, int size)
+{
+    int t = (int)(c >> Fixed::FRACTION_BITS);
+    return t < 0 || t >= size ? -1 : t;
+}
+
+// Whether the texels a span was shaded with are the ones the address mode
+// gives each pixel on a uSize by vSize texture at (uOrigin, vOrigin).
+static bool matches(const RecordingTarget& target, int w, int32_t u, int32_t v, int32_t dudx, int32_t dvdx, int uSize,
+                    int vSize, int uOrigin, int vOrigin, int (*texel)(int64_t c, int size))
+{
+    for (int i = 0; i < w; i++)
+    {
+        int expectedU = texel(u + (int64_t)i * dudx, uSize);
+        int expectedV = texel(v + (int64_t)i * dvdx, vSize);
+
+        // Border mode skips the pixel if either coordinate is outside.
+        if (expectedU < 0 || expectedV < 0)
+            expectedU = expectedV = -1;
+        else
+        {
+            expectedU += uOrigin;
+            expectedV += vOrigin;
+        }
+
+        if (target.u[i] != expectedU || target.v[i] != expectedV)
+            return false;
+    }
+
+    return true;
+}
+
+// A random span on a uSize by vSize texture, in Q16.16.
+static void randomSpan(int uSize, int vSize, int& w, int32_t& u, int32_t& v, int32_t& dudx, int32_t& dvdx)
+{
+    const int32_t U_END = uSize * Fixed::ONE, V_END = vSize * Fixed::ONE;
+    bool start = uniform(0, 1);
+
+    w = uniform(1, MAX_WIDTH);
+    u = start ? uniform(0, U_END - 1) : uniform(-3 * U_END, 4 * U_END);
+    v = start ? uniform(0, V_END - 1) : uniform(-3 * V_END, 4 * V_END);
+    dudx = uniform(0, 7) ? uniform(-3 * Fixed::ONE, 3 * Fixed::ONE) : 0;
+    dvdx = uniform(0, 7) ? uniform(-3 * Fixed::ONE, 3 * Fixed::ONE) : 0;
+}
+
+template <typename Texture, typename Address>
+static int check(const char *name, int (*texel)(int64_t c, int size))
+{
+    RecordingTarget target;
+    int different = 0, addressed = 0;
+
+    for (int c = 0; c < CASES; c++)
+    {
+        int w;
+        int32_t u, v, dudx, dvdx;
+        randomSpan(Texture::WIDTH, Texture::HEIGHT, w, u, v, dudx, dvdx);
+
+        if (!Sampler<Texture, Address>::inside(u, v, dudx, dvdx, w))
+            addressed++;
+
+        target.clear();
+        Sampler<Texture, Address>::shadeSpan(target, 0, 0, w, u, v, dudx, dvdx, NoShader());
+
+        if (!matches(target, w, u, v, dudx, dvdx, Texture::WIDTH, Texture::HEIGHT, 0, 0, texel) &&
+            different++ < MAX_REPORTED)
+            printf("%s %dx%d: span of %d from (%d, %d) by (%d, %d) differs\n", name, Texture::WIDTH,
+                   Texture::HEIGHT, w, u, v, dudx, dvdx);
+    }
+
+    printf("%s %dx%d: %d spans, %d of them reaching past the texture, %s\n", name, Texture::WIDTH, Texture::HEIGHT,
+           CASES, addressed, different ? "DIFFERENT" : "identical");
+    return different;
+}
+
+// Spans on every level of the 200x200 mip chain in its 300x200 atlas have to
+// be addressed within their level, never reading the levels next to it.
+template <typename Address>
+static int checkLevels(const char *name, int (*texel)(int64_t c, int size))
+{
+    typedef SizedTexture<300, 200> Atlas;
+    const MipChain MIPS = {200, 200, 7};
+    RecordingTarget target;
+    int different = 0, addressed = 0;
+
+    for (int c = 0; c < CASES; c++)
+    {
+        int level = uniform(0, MIPS.levels - 1), width, height, originU, originV;
+        MIPS.size(level, width, height);
+        MIPS.origin(level, originU, originV);
+
+        int w;
+        int32_t u, v, dudx, dvdx;
+        randomSpan(width, height, w, u, v, dudx, dvdx);
+
+        if (!Sampler<Atlas, Address>::inside(u, v, dudx, dvdx, w, width * Fixed::ONE, height * Fixed::ONE))
+            addressed++;
+
+        target.clear();
+        Sampler<Atlas, Address>::shadeLevelSpan(MIPS, target, 0, 0, w,
+                                                u + level * (MipChain::LEVEL_SPACING << Fixed::FRACTION_BITS), v,
+                                                dudx, dvdx, NoShader());
+
+        if (!matches(target, w, u, v, dudx, dvdx, width, height, originU, originV, texel) &&
+            different++ < MAX_REPORTED)
+            printf("%s mip level %d: span of %d from (%d, %d) by (%d, %d) differs\n", name, level, w, u, v, dudx,
+                   dvdx);
+    }
+
+    printf("%s mip levels: %d spans, %d of them reaching past their level, %s\n", name, CASES, addressed,
+           different ? "DIFFERENT" : "identical");
+    return different;
+}
+
+template <typename Texture>
+static int checkModes()
+{
+    return check<Texture, ClampAddress>("clamp", clampTexel) + check<Texture, WrapAddress>("wrap", wrapTexel) +
+           check<Texture, BorderAddress>("border", borderTexel);
+}
+
+int main()
+{
+    int failures = checkModes<SizedTexture<200, 200> >() + checkModes<SizedTexture<256, 64> >() +
+                   checkModes<SizedTexture<300, 200> >();
+
+    failures += checkLevels<ClampAddress>("clamp", clampTexel) + checkLevels<WrapAddress>("wrap", wrapTexel) +
+                checkLevels<BorderAddress>("border", borderTexel);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+// Sends random triangles under 2x2 pixels through scanTriangle(), which point
+// samples them, and checks the pixels they cover against the edge walkers
+// scanTriangle() uses for larger triangles. Half the cases are pairs sharing
+// an edge, which the top-left rule has to give to exactly one of them, and
+// some lie across the edges of the screen.
+
+#include <random>
+#include "Rasterizer.h"
+
+static const int CASES = 200000;
+static const int MAX_REPORTED = 10;
+
+static std::mt19937 generator(1);
+
+static int uniform(int low, int high)
+{
+    return std::uniform_int_distribution<int>(low, high)(generator);
+}
+
+template <int W, int H>
+struct SizedTexture
+{
+    static const int WIDTH = W;
+    static const int HEIGHT = H;
+};
+
+struct CoverageShader
+{
+    SizedTexture<200, 200> texture;
+};
+
+// Counts how often each pixel is shaded.
+struct CoverageTarget
+{
+    uint8_t runs[SCREEN_WIDTH * SCREEN_HEIGHT];
+
+    void startWrite() {}
+    void endWrite() {}
+
+    void shadeSpan(int x, int y, int w, int32_t u, int32_t v, int32_t dudx, int32_t dvdx, const CoverageShader& shader)
+    {
+        for (int i = 0; i < w; i++)
+            runs[y * SCREEN_WIDTH + x + i]++;
+    }
+};
+
+// The edge walker path of scanTriangle(), whatever the triangle's size.
+static void walkTriangle(CoverageTarget& target, RasterVertex v0, RasterVertex v1, RasterVertex v2)
+{
+    sortByY(v0, v1, v2);
+
+    UvGradients gradients;
+    if (!gradients.init(v0, v1, v2))
+        return;
+
+    EdgeWalker longEdge, upperEdge, lowerEdge;
+    longEdge.init(v0, v2, 0, SCREEN_HEIGHT);
+    upperEdge.init(v0, v1, 0, SCREEN_HEIGHT);
+    lowerEdge.init(v1, v2, 0, SCREEN_HEIGHT);
+
+    scanEdges(target, v0, v1, v2, gradients, longEdge, upperEdge, lowerEdge, CoverageShader());
+}
+
+// A vertex within two pixels less a subpixel of the corner, so the triangle
+// stays small.
+static RasterVertex vertexNear(int32_t x, int32_t y)
+{
+    return {x + uniform(0, 2 * SUBPIXEL_ONE - 1), y + uniform(0, 2 * SUBPIXEL_ONE - 1), 0, 0};
+}
+
+int main()
+{
+    static CoverageTarget sampled, walked;
+    int different = 0, covered = 0;
+
+    for (int c = 0; c < CASES; c++)
+    {
+        memset(sampled.runs, 0, sizeof(sampled.runs));
+        memset(walked.runs, 0, sizeof(walked.runs));
+
+        // Corners around every pixel of the screen and a pixel beyond it.
+        int32_t x = uniform(-2 * SUBPIXEL_ONE, (SCREEN_WIDTH + 1) * SUBPIXEL_ONE);
+        int32_t y = uniform(-2 * SUBPIXEL_ONE, (SCREEN_HEIGHT + 1) * SUBPIXEL_ONE);
+        RasterVertex v[4] = {vertexNear(x, y), vertexNear(x, y), vertexNear(x, y), vertexNear(x, y)};
+        int triangles = uniform(0, 1) ? 2 : 1;
+
+        for (int t = 0; t < triangles; t++)
+        {
+            scanTriangle(sampled, v[0], v[t + 1], v[t + 2], CoverageShader());
+            walkTriangle(walked, v[0], v[t + 1], v[t + 2]);
+        }
+
+        int x0 = floorDiv(x, SUBPIXEL_ONE), y0 = floorDiv(y, SUBPIXEL_ONE);
+
+        for (int py = y0; py <= y0 + 2; py++)
+        {
+            for (int px = x0; px <= x0 + 2; px++)
+            {
+                if (px < 0 || py < 0 || px >= SCREEN_WIDTH || py >= SCREEN_HEIGHT)
+                    continue;
+
+                int p = py * SCREEN_WIDTH + px;
+                covered += sampled.runs[p];
+
+                if (sampled.runs[p] != walked.runs[p] && different++ < MAX_REPORTED)
+                    printf("%d triangles around (%d, %d): pixel (%d, %d) shaded %d times, walked %d\n", triangles, x,
+                           y, px, py, sampled.runs[p], walked.runs[p]);
+            }
+        }
+    }
+
+    printf("%d cases, %lu triangles point sampled, %lu walked, %d pixels shaded, %s\n", CASES,
+           (unsigned long)renderStats.smallTriangles, (unsigned long)renderStats.scannedTriangles, covered,
+           different ? "DIFFERENT" : "identical");
+
+    // scanTriangle() must have point sampled every one of them, or the
+    // comparison tested nothing.
+    return different == 0 && renderStats.scannedTriangles == 0 && renderStats.smallTriangles > 0 ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// Stand-in for the parts of the Arduino core the renderer uses, so that it
+// builds and runs on the host for the tests in test/.
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROGMEM
+#define IRAM_ATTR
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long micros();
+unsigned long millis();
+
+// Serial output goes to stdout.
+struct HostSerial
+{
+    void begin(unsigned long baud) {}
+    void print(const char *s) { fputs(s, stdout); }
+    void println(const char *s = "") { puts(s); }
+
+    template <typename... Args>
+    void printf(const char *format, Args... args)
+    {
+        ::printf(format, args...);
+    }
+};
+
+extern HostSerial Serial;
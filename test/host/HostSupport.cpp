@@ -0,0 +1,18 @@
+#include <Arduino.h>
+#include <Watchy.h>
+#include <chrono>
+
+HostSerial Serial;
+HostDisplay Watchy::display;
+
+static const std::chrono::steady_clock::time_point START = std::chrono::steady_clock::now();
+
+unsigned long micros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - START).count();
+}
+
+unsigned long millis()
+{
+    return micros() / 1000;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+// Stand-in for the Watchy library on the host: the settings and time types,
+// and a display that keeps its frame in a 1 bit buffer packed the way
+// GxEPD2_BW packs it, white bits set, with the drawing calls the renderer
+// makes behaving like the Adafruit_GFX and GxEPD2 ones.
+
+#include <Arduino.h>
+
+#define GxEPD_BLACK 0x0000
+#define GxEPD_WHITE 0xFFFF
+
+struct watchySettings
+{
+    const char *cityID;
+    const char *weatherAPIKey;
+    const char *weatherURL;
+    const char *weatherUnit;
+    const char *weatherLang;
+    int8_t weatherUpdateInterval;
+    const char *ntpServer;
+    int gmtOffset;
+    int dstOffset;
+};
+
+struct tmElements_t
+{
+    uint8_t Second, Minute, Hour, Wday, Day, Month, Year;
+};
+
+struct HostDisplay
+{
+    static const int WIDTH = 200;
+    static const int HEIGHT = 200;
+
+    uint8_t buffer[WIDTH / 8 * HEIGHT];
+
+    int16_t width() const { return WIDTH; }
+    int16_t height() const { return HEIGHT; }
+
+    void startWrite() {}
+    void endWrite() {}
+    void setTextColor(uint16_t color) {}
+
+    void fillScreen(uint16_t color) { memset(buffer, color == GxEPD_BLACK ? 0x00 : 0xFF, sizeof(buffer)); }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color)
+    {
+        if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
+            return;
+
+        uint8_t bit = 0x80 >> (x & 7);
+        uint8_t &byte = buffer[y * (WIDTH / 8) + x / 8];
+        byte = color ? byte | bit : byte & ~bit;
+    }
+
+    // Adafruit_GFX::writeLine(), which drawLine() ends up in for slanted lines
+    // and, through drawFastVLine() and drawFastHLine(), for straight ones.
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+        bool steep = abs(y1 - y0) > abs(x1 - x0);
+
+        if (steep)
+        {
+            int16_t t = x0; x0 = y0; y0 = t;
+            t = x1; x1 = y1; y1 = t;
+        }
+
+        if (x0 > x1)
+        {
+            int16_t t = x0; x0 = x1; x1 = t;
+            t = y0; y0 = y1; y1 = t;
+        }
+
+        int16_t dx = x1 - x0, dy = abs(y1 - y0);
+        int16_t error = dx / 2;
+        int16_t yStep = y0 < y1 ? 1 : -1;
+
+        for (; x0 <= x1; x0++)
+        {
+            if (steep)
+                drawPixel(y0, x0, color);
+            else
+                drawPixel(x0, y0, color);
+
+            error -= dy;
+
+            if (error < 0)
+            {
+                y0 += yStep;
+                error += dx;
+            }
+        }
+    }
+
+    // Draws color where the bitmap has a 0 bit, rows padded to whole bytes.
+    void drawInvertedBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color)
+    {
+        int16_t byteWidth = (w + 7) / 8;
+
+        for (int16_t j = 0; j < h; j++)
+            for (int16_t i = 0; i < w; i++)
+                if (!(bitmap[j * byteWidth + i / 8] & (0x80 >> (i & 7))))
+                    drawPixel(x + i, y + j, color);
+    }
+};
+
+class Watchy
+{
+public:
+    static HostDisplay display;
+    tmElements_t currentTime;
+
+    // What getBatteryVoltage() reports, for the battery gauge.
+    float batteryVoltage = 4.2f;
+
+    Watchy(const watchySettings& settings) {}
+
+    void init() {}
+    float getBatteryVoltage() { return batteryVoltage; }
+};
@@ -0,0 +1,665 @@
+// Asset compiler for the textures of the watch face. Reads the PNGs listed in
+// assets/Textures.txt and writes each texture, and everything derived from
+// it, as a raw binary blob in include/textures/. src/Textures.S links every
+// blob exactly once, in a .rodata section of its own, so the linker drops the
+// ones a build does not use, and include/Textures.h declares them. Nothing is
+// compiled from hex arrays any more.
+//
+// The blobs named on the pack line of the list also go, one after the
+// other, into include/textures/Textures.pack, the image of the textures
+// partition that builds with SPIRAL_TEXTURE_PARTITION read them from instead
+// (src/TexturePartition.cpp); those builds link the other blobs as usual.
+// The pack starts with a 16 byte header, little endian: "SPTX", a hash of the
+// names, sizes and offsets of the blobs, and the size of the pack. Each blob
+// starts on a 16 byte boundary, at the offset Textures.h gives it. Textures
+// can be redrawn and the pack flashed again without rebuilding the firmware,
+// as long as the hash stays the same. The pack is not checked in.
+//
+// CMake builds it on the host when it finds libpng, and its textures target
+// runs it from the repository root, which is what ConvertTextures.bat does:
+//
+//     cmake --build build --target textures
+//     (./AssetCompiler assets/Textures.txt include src)
+//
+// The pack line is "pack" and the names of the blobs to pack. Every other
+// line of the list is a PNG next to the list, then what to build from it
+// besides its texels, <name>.bin:
+//
+//     --minmax       <name>MinMax.bin, the darkest and lightest texel of every
+//                    2x2, 4x4, 8x8... block (GrayTexture::range())
+//     --minmax-rows  <name>MinMax.bin with 8x1 blocks instead, one per frame
+//                    buffer byte, for the noise mask
+//     --mips         <name>Mips.bin, the mip chain atlas: the image, and to
+//                    its right every level half the size of the one before,
+//                    averaged 2x2 and stacked top to bottom, as many as fit.
+//                    With --minmax also <name>MipsMinMax.bin.
+//     --palette4     <name>Palette4.bin, quantized to the 16 gray levels that
+//                    keep the squared error lowest: the levels, then the rows
+//                    with two texels per byte, the left one in the high nibble
+//     --padded, --tiled4, --tiled8, --morton
+//                    <name>Padded.bin and so on, the texels in the orders of
+//                    SPIRAL_TEXTURE_LAYOUT, gaps filled with zeros
+//
+// Texels are the red channel of the image, which is what the watch face has
+// always been drawn with; alpha is ignored. The header records a hash of each
+// PNG and its options, and textures whose hash and blobs are still there are
+// not decoded again. Files whose contents stay the same are not rewritten, so
+// the firmware only rebuilds what changed.
+
+#include <png.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Image
+{
+    int width, height;
+    std::vector<uint8_t> texels;   // row major
+
+    uint8_t at(int x, int y) const { return texels[y * width + x]; }
+};
+
+// One line of the list.
+struct Asset
+{
+    std::string file;
+    std::string name;
+    std::vector<std::string> options;
+    std::string line;
+
+    bool has(const char *option) const
+    {
+        for (size_t i = 0; i < options.size(); i++)
+            if (options[i] == option)
+                return true;
+        return false;
+    }
+};
+
+static const char *const LAYOUTS[][2] = {
+    {"--padded", "Padded"}, {"--tiled4", "Tiled4"}, {"--tiled8", "Tiled8"}, {"--morton", "Morton"}};
+static const int LAYOUT_COUNT = sizeof(LAYOUTS) / sizeof(LAYOUTS[0]);
+
+static const int PACK_HEADER = 16;
+static const int PACK_ALIGNMENT = 16;
+
+static void fail(const std::string& message)
+{
+    fprintf(stderr, "Error: %s\n", message.c_str());
+    exit(1);
+}
+
+static bool readFile(const std::string& path, std::string& contents)
+{
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in)
+        return false;
+
+    std::ostringstream s;
+    s << in.rdbuf();
+    contents = s.str();
+    return true;
+}
+
+// Leaves files that already hold contents alone, so their time stamps only
+// change when they do.
+static bool writeIfChanged(const std::string& path, const std::string& contents)
+{
+    std::string old;
+    if (readFile(path, old) && old == contents)
+        return false;
+
+    std::ofstream out(path.c_str(), std::ios::binary);
+    out << contents;
+    if (!out)
+        fail("unable to write " + path);
+    return true;
+}
+
+static uint64_t fnv1a(const std::string& data, uint64_t hash = 14695981039346656037ull)
+{
+    for (size_t i = 0; i < data.size(); i++)
+        hash = (hash ^ (uint8_t)data[i]) * 1099511628211ull;
+    return hash;
+}
+
+static Image readPng(const std::string& path)
+{
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+
+    if (!png_image_begin_read_from_file(&png, path.c_str()))
+        fail("unable to open " + path + ": " + png.message);
+
+    png.format = PNG_FORMAT_RGBA;
+    std::vector<uint8_t> rgba(PNG_IMAGE_SIZE(png));
+
+    if (!png_image_finish_read(&png, NULL, rgba.data(), 0, NULL))
+        fail("unable to decode " + path + ": " + png.message);
+
+    Image image;
+    image.width = png.width;
+    image.height = png.height;
+    image.texels.resize(image.width * image.height);
+
+    for (size_t i = 0; i < image.texels.size(); i++)
+        image.texels[i] = rgba[i * 4];
+
+    return image;
+}
+
+// Darkest and lightest texel of each block of a level, from the blocks of the
+// level below, bw by bh of them at a time. Blocks on the right and bottom
+// edge only cover what is left of the image.
+struct MinMaxLevel
+{
+    int width, height;
+    std::vector<uint8_t> low, high;
+
+    MinMaxLevel reduce(int bw, int bh) const
+    {
+        MinMaxLevel next;
+        next.width = (width + bw - 1) / bw;
+        next.height = (height + bh - 1) / bh;
+        next.low.assign(next.width * next.height, 255);
+        next.high.assign(next.width * next.height, 0);
+
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                int i = (y / bh) * next.width + x / bw;
+
+                next.low[i] = std::min(next.low[i], low[y * width + x]);
+                next.high[i] = std::max(next.high[i], high[y * width + x]);
+            }
+        }
+
+        return next;
+    }
+};
+
+// Each level row major, min and max of a block next to each other, levels
+// one after another from the smallest blocks up.
+static std::vector<uint8_t> minMax(const Image& image, bool rows)
+{
+    MinMaxLevel level = {image.width, image.height, image.texels, image.texels};
+    std::vector<uint8_t> bytes;
+
+    while (level.width > 1 || level.height > 1)
+    {
+        level = rows ? level.reduce(8, 1) : level.reduce(2, 2);
+
+        for (size_t i = 0; i < level.low.size(); i++)
+        {
+            bytes.push_back(level.low[i]);
+            bytes.push_back(level.high[i]);
+        }
+
+        if (rows)
+            break;
+    }
+
+    return bytes;
+}
+
+// Every level is the rounded average of 2x2 texels of the level before,
+// fewer on odd edges.
+static Image mipAtlas(const Image& image)
+{
+    Image atlas;
+    atlas.width = image.width + (image.width + 1) / 2;
+    atlas.height = image.height;
+    atlas.texels.assign(atlas.width * atlas.height, 0);
+
+    for (int y = 0; y < image.height; y++)
+        for (int x = 0; x < image.width; x++)
+            atlas.texels[y * atlas.width + x] = image.at(x, y);
+
+    Image level = image;
+
+    for (int top = 0; level.width > 1 || level.height > 1;)
+    {
+        Image next;
+        next.width = (level.width + 1) / 2;
+        next.height = (level.height + 1) / 2;
+
+        if (top + next.height > image.height)
+            break;
+
+        next.texels.resize(next.width * next.height);
+
+        for (int y = 0; y < next.height; y++)
+        {
+            for (int x = 0; x < next.width; x++)
+            {
+                int sum = 0, count = 0;
+
+                for (int j = y * 2; j < std::min(y * 2 + 2, level.height); j++)
+                {
+                    for (int i = x * 2; i < std::min(x * 2 + 2, level.width); i++)
+                    {
+                        sum += level.at(i, j);
+                        count++;
+                    }
+                }
+
+                next.texels[y * next.width + x] = (sum + count / 2) / count;
+                atlas.texels[(top + y) * atlas.width + image.width + x] = next.texels[y * next.width + x];
+            }
+        }
+
+        top += next.height;
+        level = next;
+    }
+
+    return atlas;
+}
+
+// Optimal quantizers in one dimension split the sorted values into runs, so
+// the runs are found by dynamic programming over the histogram. Levels are
+// ascending, padded with the last one if the image has fewer values.
+static std::vector<int> paletteLevels(const Image& image)
+{
+    const int LEVELS = 16;
+    long count[256] = {0};
+
+    for (size_t i = 0; i < image.texels.size(); i++)
+        count[image.texels[i]]++;
+
+    std::vector<int> values;
+    for (int v = 0; v < 256; v++)
+        if (count[v])
+            values.push_back(v);
+
+    if (values.size() <= (size_t)LEVELS)
+    {
+        std::vector<int> levels = values;
+        levels.resize(LEVELS, values.back());
+        return levels;
+    }
+
+    // Prefix sums over the used values, for the error of any run in O(1).
+    int n = values.size();
+    std::vector<int64_t> weight(n + 1, 0), first(n + 1, 0), second(n + 1, 0);
+
+    for (int k = 0; k < n; k++)
+    {
+        int64_t v = values[k];
+        weight[k + 1] = weight[k] + count[v];
+        first[k + 1] = first[k] + count[v] * v;
+        second[k + 1] = second[k] + count[v] * v * v;
+    }
+
+    // best[k][j]: least error of the first j values in k runs.
+    std::vector<std::vector<double> > best(LEVELS + 1, std::vector<double>(n + 1, INFINITY));
+    std::vector<std::vector<int> > split(LEVELS + 1, std::vector<int>(n + 1, 0));
+    best[0][0] = 0;
+
+    for (int k = 1; k <= LEVELS; k++)
+    {
+        for (int j = k; j <= n; j++)
+        {
+            for (int i = k - 1; i < j; i++)
+            {
+                int64_t w = weight[j] - weight[i], f = first[j] - first[i];
+                double e = best[k - 1][i] + ((double)(second[j] - second[i]) - (double)(f * f) / w);
+
+                if (e < best[k][j])
+                {
+                    best[k][j] = e;
+                    split[k][j] = i;
+                }
+            }
+        }
+    }
+
+    // Means round half to even, like the quantizer this one replaced.
+    std::vector<int> levels;
+    for (int k = LEVELS, j = n; k > 0; k--)
+    {
+        int i = split[k][j];
+        levels.push_back((int)std::nearbyint((double)(first[j] - first[i]) / (weight[j] - weight[i])));
+        j = i;
+    }
+
+    std::sort(levels.begin(), levels.end());
+    return levels;
+}
+
+static std::vector<uint8_t> palette4(const Image& image)
+{
+    std::vector<int> levels = paletteLevels(image);
+    std::vector<uint8_t> bytes(levels.begin(), levels.end());
+    uint8_t index[256];
+
+    // The closest level, the first of equally close ones.
+    for (int v = 0; v < 256; v++)
+    {
+        index[v] = 0;
+        for (int k = 1; k < (int)levels.size(); k++)
+            if (abs(levels[k] - v) < abs(levels[index[v]] - v))
+                index[v] = k;
+    }
+
+    for (int y = 0; y < image.height; y++)
+    {
+        for (int x = 0; x < image.width; x += 2)
+        {
+            uint8_t right = x + 1 < image.width ? index[image.at(x + 1, y)] : 0;
+            bytes.push_back(index[image.at(x, y)] << 4 | right);
+        }
+    }
+
+    return bytes;
+}
+
+// Texel index functions of the layouts, the same as TexelLayout in Texture.h.
+static uint32_t spreadBits(uint32_t x)
+{
+    uint32_t spread = 0;
+    for (int k = 0; k < 16; k++)
+        spread |= ((x >> k) & 1) << (2 * k);
+    return spread;
+}
+
+static uint32_t layoutIndex(int layout, const Image& image, int u, int v)
+{
+    int stride = 1, tile = layout == 1 ? 4 : 8;
+    while (stride < image.width)
+        stride *= 2;
+
+    switch (layout)
+    {
+    case 0:
+        return v * stride + u;
+    case 3:
+        return spreadBits(u) | spreadBits(v) << 1;
+    default:
+        return ((v / tile) * ((image.width + tile - 1) / tile) + u / tile) * tile * tile + (v % tile) * tile + u % tile;
+    }
+}
+
+// Runs up to the last texel.
+static std::vector<uint8_t> layout(const Image& image, int layout)
+{
+    std::vector<uint8_t> bytes;
+
+    for (int y = 0; y < image.height; y++)
+    {
+        for (int x = 0; x < image.width; x++)
+        {
+            uint32_t i = layoutIndex(layout, image, x, y);
+            if (i >= bytes.size())
+                bytes.resize(i + 1, 0);
+            bytes[i] = image.at(x, y);
+        }
+    }
+
+    return bytes;
+}
+
+// Names of the blobs an asset's options ask for, in the order build() makes
+// them.
+static std::vector<std::string> blobNames(const Asset& asset)
+{
+    std::vector<std::string> names(1, asset.name);
+
+    if (asset.has("--minmax") || asset.has("--minmax-rows"))
+        names.push_back(asset.name + "MinMax");
+    if (asset.has("--mips"))
+        names.push_back(asset.name + "Mips");
+    if (asset.has("--mips") && asset.has("--minmax"))
+        names.push_back(asset.name + "MipsMinMax");
+    if (asset.has("--palette4"))
+        names.push_back(asset.name + "Palette4");
+    for (int l = 0; l < LAYOUT_COUNT; l++)
+        if (asset.has(LAYOUTS[l][0]))
+            names.push_back(asset.name + LAYOUTS[l][1]);
+
+    return names;
+}
+
+static std::vector<std::vector<uint8_t> > build(const Asset& asset, const Image& image)
+{
+    std::vector<std::vector<uint8_t> > blobs(1, image.texels);
+
+    if (asset.has("--minmax") || asset.has("--minmax-rows"))
+        blobs.push_back(minMax(image, asset.has("--minmax-rows")));
+    if (asset.has("--mips"))
+    {
+        Image atlas = mipAtlas(image);
+        blobs.push_back(atlas.texels);
+
+        if (asset.has("--minmax"))
+            blobs.push_back(minMax(atlas, false));
+    }
+    if (asset.has("--palette4"))
+        blobs.push_back(palette4(image));
+    for (int l = 0; l < LAYOUT_COUNT; l++)
+        if (asset.has(LAYOUTS[l][0]))
+            blobs.push_back(layout(image, l));
+
+    return blobs;
+}
+
+static std::vector<Asset> readList(const std::string& path, std::vector<std::string>& packed)
+{
+    std::string contents;
+    if (!readFile(path, contents))
+        fail("unable to open " + path);
+
+    std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+    std::vector<Asset> assets;
+    std::istringstream lines(contents);
+
+    for (std::string line; std::getline(lines, line);)
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+
+        std::istringstream words(line);
+        Asset asset;
+        if (!(words >> asset.file) || asset.file[0] == '#')
+            continue;
+
+        if (asset.file == "pack")
+        {
+            for (std::string name; words >> name;)
+                packed.push_back(name);
+            continue;
+        }
+
+        for (std::string option; words >> option;)
+        {
+            bool known = option == "--minmax" || option == "--minmax-rows" || option == "--mips" ||
+                         option == "--palette4";
+            for (int l = 0; l < LAYOUT_COUNT; l++)
+                known |= option == LAYOUTS[l][0];
+
+            if (!known)
+                fail("unknown option " + option + " for " + asset.file);
+            asset.options.push_back(option);
+        }
+
+        if (asset.has("--minmax") && asset.has("--minmax-rows"))
+            fail("--minmax and --minmax-rows both given for " + asset.file);
+
+        size_t slash = asset.file.find_last_of("/\\"), dot = asset.file.find_last_of('.');
+        size_t start = slash == std::string::npos ? 0 : slash + 1;
+        asset.name = asset.file.substr(start, dot == std::string::npos || dot < start ? std::string::npos : dot - start);
+        asset.line = line;
+        asset.file = directory + asset.file;
+        assets.push_back(asset);
+    }
+
+    return assets;
+}
+
+// Hashes the header recorded for each line of the list, from the lines of the
+// form "// asset <line> : <hash>".
+static std::string recordedHash(const std::string& header, const std::string& line)
+{
+    std::string key = "// asset " + line + " : ";
+    size_t at = header.find(key);
+    return at == std::string::npos ? "" : header.substr(at + key.size(), 16);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 4)
+    {
+        fprintf(stderr, "Usage: %s <list> <include directory> <source directory>\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> packed;
+    std::vector<Asset> assets = readList(argv[1], packed);
+    std::string includeDirectory = std::string(argv[2]) + "/", sourceDirectory = std::string(argv[3]) + "/";
+    std::string headerPath = includeDirectory + "Textures.h", oldHeader;
+    readFile(headerPath, oldHeader);
+
+    std::string listName = argv[1];
+    listName = listName.substr(listName.find_last_of("/\\") + 1);
+
+    std::ostringstream header, section;
+    header << "// Generated by tools/AssetCompiler.cpp from assets/" << listName << ", do not edit.\n"
+           << "// The blobs are in include/textures/, linked once by src/Textures.S, and the\n"
+           << "// ones on the pack line packed into include/textures/Textures.pack for the\n"
+           << "// textures partition.\n//\n";
+    section << "/* Generated by tools/AssetCompiler.cpp from assets/" << listName << ", do not edit. */\n"
+            << "\n/* Builds with SPIRAL_TEXTURE_PARTITION read the packed blobs from the textures\n"
+            << "   partition, and link the others as <name>Linked for Textures.h to point at. */\n"
+            << "#if defined(SPIRAL_TEXTURE_PARTITION) && SPIRAL_TEXTURE_PARTITION\n"
+            << "#define PARTITION 1\n"
+            << "#define LINKED(name) name##Linked\n"
+            << "#else\n"
+            << "#define PARTITION 0\n"
+            << "#define LINKED(name) name\n"
+            << "#endif\n";
+
+    std::ostringstream declarations, blobList, handles, layout;
+    std::vector<bool> found(packed.size());
+    std::string pack(PACK_HEADER, '\0');
+    int built = 0;
+
+    for (size_t a = 0; a < assets.size(); a++)
+    {
+        const Asset& asset = assets[a];
+        std::string png;
+        if (!readFile(asset.file, png))
+            fail("unable to open " + asset.file);
+
+        char hash[17];
+        snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)fnv1a(asset.line, fnv1a(png)));
+        header << "// asset " << asset.line << " : " << hash << "\n";
+
+        std::vector<std::string> names = blobNames(asset);
+        bool upToDate = recordedHash(oldHeader, asset.line) == hash;
+
+        std::vector<std::string> contents(names.size());
+
+        for (size_t b = 0; b < names.size() && upToDate; b++)
+            upToDate = readFile(includeDirectory + "textures/" + names[b] + ".bin", contents[b]);
+
+        if (!upToDate)
+        {
+            Image image = readPng(asset.file);
+            std::vector<std::vector<uint8_t> > blobs = build(asset, image);
+
+            for (size_t b = 0; b < blobs.size(); b++)
+            {
+                contents[b].assign(blobs[b].begin(), blobs[b].end());
+                writeIfChanged(includeDirectory + "textures/" + names[b] + ".bin", contents[b]);
+            }
+
+            printf("%s: %d x %d, %d blobs\n", asset.line.c_str(), image.width, image.height, (int)blobs.size());
+            built++;
+        }
+
+        for (size_t b = 0; b < names.size(); b++)
+        {
+            size_t size = contents[b].size();
+            size_t p = std::find(packed.begin(), packed.end(), names[b]) - packed.begin();
+            std::string label = names[b];
+
+            declarations << "extern const unsigned char " << names[b] << "[" << size << "];\n";
+
+            if (p < packed.size())
+            {
+                size_t offset = pack.size();
+                pack += contents[b];
+                pack.resize((pack.size() + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT, '\0');
+                layout << names[b] << " " << size << " " << offset << "\n";
+
+                found[p] = true;
+                blobList << " \\\n    X(" << names[b] << ", " << offset << ")";
+                handles << "extern const unsigned char *" << names[b] << ";\n";
+                section << "\n#if !PARTITION";
+            }
+            else
+            {
+                label = "LINKED(" + names[b] + ")";
+                handles << "extern const unsigned char " << names[b] << "Linked[" << size << "];\n"
+                        << "static const unsigned char *const " << names[b] << " = " << names[b] << "Linked;\n";
+            }
+
+            section << "\n"
+                    << "    .section .rodata." << names[b] << ", \"a\"\n"
+                    << "    .balign 16\n"
+                    << "    .global " << label << "\n"
+                    << "    .type " << label << ", %object\n"
+                    << "    .size " << label << ", " << size << "\n"
+                    << label << ":\n"
+                    << "    .incbin \"textures/" << names[b] << ".bin\"\n";
+
+            if (p < packed.size())
+                section << "#endif\n";
+        }
+    }
+
+    for (size_t p = 0; p < packed.size(); p++)
+        if (!found[p])
+            fail("no blob " + packed[p] + " to pack");
+
+    uint32_t layoutHash = (uint32_t)fnv1a(layout.str());
+    const uint32_t header32[] = {0x58545053, layoutHash, (uint32_t)pack.size(), 0};   // "SPTX"
+
+    for (int i = 0; i < PACK_HEADER; i++)
+        pack[i] = (char)(header32[i / 4] >> (i % 4 * 8));
+
+    char hex[11];
+    snprintf(hex, sizeof(hex), "0x%08x", layoutHash);
+
+    header << "\n#pragma once\n\n"
+           << "#if SPIRAL_TEXTURE_PARTITION\n"
+           << "// The packed blobs and their offsets in include/textures/Textures.pack. Their\n"
+           << "// pointers are null until mapTextures() (src/TexturePartition.cpp) points them\n"
+           << "// into the textures partition; it returns an error message, or nullptr.\n"
+           << "#define TEXTURE_PACK_LAYOUT " << hex << "u\n"
+           << "#define TEXTURE_PACK_SIZE " << pack.size() << "\n"
+           << "#define TEXTURE_PACK_BLOBS(X)" << blobList.str() << "\n\n"
+           << "const char *mapTextures();\n\n"
+           << "extern \"C\" {\n" << handles.str() << "}\n"
+           << "#else\n"
+           << "extern \"C\" {\n" << declarations.str() << "}\n"
+           << "#endif\n";
+    section << "\n#if defined(__linux__) && defined(__ELF__)\n"
+            << "    .section .note.GNU-stack, \"\", %progbits\n"
+            << "#endif\n";
+
+    writeIfChanged(headerPath, header.str());
+    writeIfChanged(sourceDirectory + "Textures.S", section.str());
+    writeIfChanged(includeDirectory + "textures/Textures.pack", pack);
+
+    printf("%d of %d textures built, the others were up to date\n", built, (int)assets.size());
+    return 0;
+}
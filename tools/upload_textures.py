@@ -0,0 +1,44 @@
+# PlatformIO extra script for the environments with SPIRAL_TEXTURE_PARTITION.
+# Adds an "uploadtextures" target that writes include/textures/Textures.pack,
+# as tools/AssetCompiler.cpp last wrote it, to the textures partition. The
+# pack is not checked in; the CMake textures target builds it:
+#
+#     cmake --build build --target textures
+#     pio run -e watchy_texture_partition -t uploadtextures
+#
+# The app is uploaded as usual and only needs it again when the offsets in
+# include/Textures.h change.
+
+import csv
+import os
+
+Import("env")
+
+PACK = os.path.join("$PROJECT_DIR", "include", "textures", "Textures.pack")
+
+
+def texturePartitionOffset():
+    table = env.subst("$PROJECT_DIR/" + env.GetProjectOption("board_build.partitions"))
+    with open(table) as rows:
+        for row in csv.reader(rows):
+            if row and row[0].strip() == "textures":
+                return row[3].strip()
+    raise SystemExit("No textures partition in " + table)
+
+
+def checkPack(target, source, env):
+    if not os.path.isfile(env.subst(PACK)):
+        raise SystemExit("No " + env.subst(PACK) + ", build it with: cmake --build build --target textures")
+
+
+env.AddCustomTarget(
+    name="uploadtextures",
+    dependencies=None,
+    actions=[
+        checkPack,
+        env.VerboseAction(env.AutodetectUploadPort, "Looking for upload port..."),
+        '"$PYTHONEXE" "$UPLOADER" $UPLOADERFLAGS %s "%s"' % (texturePartitionOffset(), PACK),
+    ],
+    title="Upload textures",
+    description="Writes the texture pack to the textures partition",
+)